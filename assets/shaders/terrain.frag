@@ -5,9 +5,8 @@ out vec4 FragColor;
 in float Height;
 in vec2 texCoord;
 
-uniform sampler2D ourTexture1; // grass
-uniform sampler2D ourTexture2; // rock
-uniform sampler2D ourTexture3; // rock
+// Layer 0 grass, 1 rock, 2 snow
+uniform sampler2DArray materials;
 uniform float heightMin; 
 uniform float heightMax;
 
@@ -21,9 +20,9 @@ void main()
     float h = (Height - heightMin) / delta;
 
     // Texture sampling
-    vec3 tex1 = texture(ourTexture1, texCoord * 10.0).rgb;
-    vec3 tex2 = texture(ourTexture2, texCoord * 10.0).rgb;
-    vec3 tex3 = texture(ourTexture3, texCoord * 10.0).rgb;
+    vec3 tex1 = texture(materials, vec3(texCoord * 10.0, 0.0)).rgb;
+    vec3 tex2 = texture(materials, vec3(texCoord * 10.0, 1.0)).rgb;
+    vec3 tex3 = texture(materials, vec3(texCoord * 10.0, 2.0)).rgb;
 
     // Smooth transition ranges
     float blend1 = smoothstep(0.4, 0.6, h); // Transition between grass and rock
@@ -1,6 +1,10 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+
+// One instance per patch: map cell of its corner, cell spacing (2^level with
+// level of detail) and the camera distances over which it morphs to the next
+// coarser level
+layout (location = 0) in vec3 patchOrigin;
+layout (location = 1) in vec2 patchMorph;
 
 out float Height;
 out vec2 texCoord;
@@ -8,10 +12,55 @@ out vec2 texCoord;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 cameraPosition;
+
+// Raw generator heights, one texel per grid vertex: texel (z, x) is map
+// cell (x, z). The patch indices are patch-local x * kPatchVertices + z.
+uniform sampler2D heightMap;
+
+const int kChunkSize = 64;  // Terrain::kChunkSize
+const int kPatchVertices = kChunkSize + 1;
+uniform float yScale;
+uniform float yShift;
+
+float sampleHeight(vec2 cell, ivec2 size)
+{
+    // Bilinear between texels, so morphing vertices glide instead of snapping
+    vec2 base = floor(cell);
+    vec2 f = cell - base;
+    ivec2 x0 = ivec2(base);
+    ivec2 x1 = min(x0 + 1, ivec2(size.y - 1, size.x - 1));
+    float h00 = texelFetch(heightMap, ivec2(x0.y, x0.x), 0).r;
+    float h01 = texelFetch(heightMap, ivec2(x1.y, x0.x), 0).r;
+    float h10 = texelFetch(heightMap, ivec2(x0.y, x1.x), 0).r;
+    float h11 = texelFetch(heightMap, ivec2(x1.y, x1.x), 0).r;
+    return mix(mix(h00, h01, f.y), mix(h10, h11, f.y), f.x);
+}
 
 void main()
 {
-    Height = aPos.y;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    texCoord = aTexCoord;
-}
\ No newline at end of file
+    ivec2 size = textureSize(heightMap, 0);
+    vec2 mapEnd = vec2(size.y - 1, size.x - 1);
+    vec2 local = vec2(gl_VertexID / kPatchVertices, gl_VertexID % kPatchVertices);
+    vec2 origin = vec2(-size.y / 2.0, -size.x / 2.0);
+
+    // Patches on the far edges overhang the map; their extra vertices clamp
+    // onto the edge and only make degenerate triangles
+    vec2 cell = min(patchOrigin.xy + local * patchOrigin.z, mapEnd);
+    float height = texelFetch(heightMap, ivec2(cell.y, cell.x), 0).r * yScale - yShift;
+    vec3 position = vec3(origin.x + cell.x, height, origin.y + cell.y);
+
+    // Odd rows and columns slide onto their even neighbours as the camera
+    // moves away, so at patchMorph.y the patch matches the next level's grid
+    float morph = clamp((distance(cameraPosition, position) - patchMorph.x) / (patchMorph.y - patchMorph.x), 0.0, 1.0);
+    if (morph > 0.0) {
+        local -= fract(local * 0.5) * 2.0 * morph;
+        cell = min(patchOrigin.xy + local * patchOrigin.z, mapEnd);
+        height = sampleHeight(cell, size) * yScale - yShift;
+        position = vec3(origin.x + cell.x, height, origin.y + cell.y);
+    }
+
+    Height = position.y;
+    gl_Position = projection * view * model * vec4(position, 1.0);
+    texCoord = cell / mapEnd * 10.0;
+}
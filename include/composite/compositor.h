@@ -0,0 +1,45 @@
+#pragma once
+
+#include <terrain/heightfield.h>
+#include <vector>
+
+// Blends any number of equally sized layers into one height map.
+// Weights are per-layer gains (missing entries count as 1). Each output tile
+// reads every layer once and writes the result once, and tiles run in
+// parallel; the result does not depend on thread count.
+class Compositor {
+public:
+    enum class Op {
+        ADD,          // sum of w_i * layer_i
+        MAX,
+        MIN,
+        WEIGHTED,     // sum of w_i * layer_i / sum of w_i
+        MULTIPLY,
+        LERP_BY_MASK, // layers {a, b, mask}: a + (b - a) * clamp(mask, 0, 1)
+        SMOOTH_MAX    // max with the corners rounded over a width of `smoothness`
+    };
+
+    explicit Compositor(Op op = Op::MAX, std::vector<float> weights = {}, float smoothness = 0.1f);
+
+    void setOp(Op op);
+    void setWeights(std::vector<float> weights);
+    void setSmoothness(float smoothness);
+
+    Op getOp() const;
+    const std::vector<float>& getWeights() const;
+    float getSmoothness() const;
+
+    // Overwrites target; every layer must have target's size
+    void apply(HeightField& target, const std::vector<const HeightField*>& layers) const;
+
+private:
+    template <class Combine>
+    void blendTile(HeightField& target, const std::vector<const HeightField*>& layers,
+                   const std::vector<float>& gains, float scale, const TileRange& tile, Combine combine) const;
+    void lerpTile(HeightField& target, const std::vector<const HeightField*>& layers,
+                  const std::vector<float>& gains, const TileRange& tile) const;
+
+    Op m_op;
+    std::vector<float> m_weights;
+    float m_smoothness;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <terrain/heightfield.h>
+#include <terrain/generation_control.h>
+
+// Droplet (particle) hydraulic erosion, run as a post-process on any height map.
+// Each droplet rolls downhill for a bounded number of one-cell steps, picking
+// up sediment through a precomputed circular brush while it speeds up and
+// dropping it where it slows down or pools.
+//
+// Droplets are spawned per tile. A tile is at least twice as wide as the
+// furthest a droplet can read or write from its tile, so tiles of the same
+// colour in a 2x2 checkerboard never touch the same cells and run in
+// parallel; the four colours run one after another. Spawn points are hashed
+// from the seed, tile and droplet index and droplets step in a fixed order,
+// so the result depends only on the seed, never on the thread count.
+class HydraulicErosion {
+public:
+    HydraulicErosion(int droplets = 0, std::uint32_t seed = 1337);
+
+    void setDroplets(int droplets);
+    void setSeed(std::uint32_t seed);
+    void setLifetime(int steps);
+    void setBrushRadius(int radius);
+
+    int getDroplets() const;
+
+    // control, if given, is checked between the four colour passes
+    void apply(HeightField& heightMap, GenerationControl* control = nullptr) const;
+
+    // Droplet tuning, in height map units
+    float inertia = 0.05f;             // how much of the old direction is kept
+    float sedimentCapacity = 4.0f;     // capacity per unit of drop * speed * water
+    float minSedimentCapacity = 0.01f;
+    float erodeSpeed = 0.3f;
+    float depositSpeed = 0.3f;
+    float evaporateSpeed = 0.01f;
+    float gravity = 4.0f;
+    float initialWater = 1.0f;
+    float initialSpeed = 1.0f;
+
+private:
+    void buildBrush();
+    int tileSize() const;
+    void simulateTile(HeightField& heightMap, const TileRange& tile, int tileIndex, int droplets) const;
+
+    int m_droplets;
+    std::uint32_t m_seed;
+    int m_lifetime = 30;
+    int m_brushRadius = 3;
+
+    // Erosion brush as offsets from the droplet's cell and normalised weights
+    std::vector<int> m_brushX;
+    std::vector<int> m_brushZ;
+    std::vector<float> m_brushWeight;
+};
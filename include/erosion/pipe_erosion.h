@@ -0,0 +1,59 @@
+#pragma once
+
+#include <terrain/heightfield.h>
+#include <terrain/generation_control.h>
+
+// Grid hydraulic erosion using the virtual pipe (shallow water) model.
+// Water flows between neighbouring cells through virtual pipes driven by the
+// difference in water surface height; moving water dissolves terrain up to a
+// capacity set by its speed and the local slope, and drops the rest. Sediment
+// leaves a cell through the pipes in proportion to its water, so it is
+// conserved.
+//
+// All state lives in HeightFields shaped like the terrain (with a one-cell
+// ghost border), one array per quantity. Each step runs three passes over
+// row bands on the thread pool; every pass only writes the cells it owns, so
+// the result does not depend on the thread count.
+class PipeErosion {
+public:
+    PipeErosion(int steps = 0);
+
+    void setSteps(int steps);
+    int getSteps() const;
+
+    // control, if given, is checked once per step
+    void apply(HeightField& heightMap, GenerationControl* control = nullptr);
+
+    // Simulation tuning, in height map units with one cell = 1
+    float timeStep = 0.05f;
+    float rainRate = 0.01f;           // water added per unit time
+    float pipeArea = 1.0f;            // cross section / length of a pipe
+    float gravity = 9.81f;
+    float sedimentCapacity = 0.1f;
+    float dissolveRate = 0.3f;
+    float depositRate = 0.3f;
+    float evaporationRate = 0.02f;
+    float minTilt = 0.05f;            // keeps flat ground from never eroding
+    float maxErosionDepth = 0.01f;    // water depth at which capacity stops growing
+
+private:
+    void resize(int width, int height);
+    void refreshBorders();
+
+    void computeFlux(int x0, int x1);
+    void transportSediment(int x0, int x1);
+    void updateWater(int x0, int x1);
+
+    int m_steps;
+
+    HeightField m_terrain;
+    HeightField m_water;
+    HeightField m_sediment;
+    HeightField m_sedimentNext;
+    // Outflow towards x-1, x+1, z-1, z+1
+    HeightField m_fluxUp;
+    HeightField m_fluxDown;
+    HeightField m_fluxLeft;
+    HeightField m_fluxRight;
+    HeightField m_slope;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <limits>
+#include <terrain/heightfield.h>
+
+// Thermal (talus) erosion shared by the generators.
+// Every iteration each cell looks at its steepest downhill neighbour and, if
+// the drop exceeds the talus height, sends min((drop - talus) * rate, maxTransfer)
+// to it. Iterations ping-pong between the height map and a scratch grid, and
+// each cell gathers what its neighbours sent it, so row bands run in parallel
+// without touching each other's output. Results do not depend on thread count.
+class ThermalErosion {
+public:
+    ThermalErosion(int iterations = 3, float talus = 0.05f, float rate = 0.5f,
+                   float maxTransfer = std::numeric_limits<float>::infinity());
+
+    void setIterations(int iterations);
+    void setTalus(float talus);
+    void setRate(float rate);
+    void setMaxTransfer(float maxTransfer);
+
+    int getIterations() const;
+    float getTalus() const;
+
+    void apply(HeightField& heightMap);
+
+private:
+    void erodeBand(ConstHeightFieldView source, HeightFieldView target, int x0, int x1) const;
+
+    int m_iterations;
+    float m_talus;
+    float m_rate;
+    float m_maxTransfer;
+
+    // Second ping-pong buffer, kept between calls to avoid reallocating
+    HeightField m_scratch;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Cellular (Worley) noise on a unit grid. Each cell holds one feature point
+// placed by an integer hash of the cell coordinates and seed, so no gradient
+// noise is evaluated to jitter points, and the 3x3 search compares squared
+// distances (one sqrt per sample for the final value).
+class CellularNoise {
+public:
+    enum class Distance {
+        F1,     // distance to the nearest feature point
+        F2,     // distance to the second nearest
+        EDGE    // F2 - F1, zero along cell borders
+    };
+
+    // jitter: 0 = points at cell centres (regular grid), 1 = anywhere in the cell
+    explicit CellularNoise(std::uint32_t seed = 0, float jitter = 1.0f);
+
+    float noise2D(float x, float y, Distance distance = Distance::F1) const;
+
+    // out[i] = noise2D(xs[i], ys[i]); runs one SIMD vector of samples per step
+    void noise2D(const float* xs, const float* ys, float* out, size_t count,
+                 Distance distance = Distance::F1) const;
+
+private:
+    std::uint32_t m_seed;
+    float m_jitter;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool shared by the terrain generators.
+// parallelFor() lets the calling thread take work too, so it is safe to call
+// from inside a pool task (the caller just ends up doing most of the work).
+class ThreadPool {
+public:
+    // 0 = one thread per hardware core
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total threads taking part in parallelFor, including the caller
+    unsigned getThreadCount() const;
+
+    // Runs fn(i) for every i in [0, count) and blocks until all have finished.
+    // Which thread runs which index is unspecified, so fn must not depend on it.
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    // Queues a single task on a worker
+    template <class F>
+    auto submit(F&& fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Process-wide pool used by the generators
+    static ThreadPool& global();
+    // Rebuilds the global pool; only call while no generation is running
+    static void setGlobalThreadCount(unsigned threadCount);
+
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    bool m_stopping = false;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <simd/simd.h>
+
+#include <cstdint>
+
+// Stream ids, so stages that share a seed draw unrelated numbers
+enum class RngStream : std::uint32_t {
+    FAULT_LINES = 1,
+    MIDPOINT_DISPLACEMENT,
+    EROSION_DROPLETS
+};
+
+// Stateless counter-based random numbers. A draw is a hash of the seed, a
+// stream id and up to three counters (typically a position or index and a
+// draw number), so any draw can be made on any thread, in any order, and
+// always comes out the same for the same seed.
+class CounterRng {
+public:
+    constexpr CounterRng(std::uint32_t seed = 0, RngStream stream = RngStream::FAULT_LINES)
+        : m_key(mix(seed * 0x9e3779b9u ^ mix(static_cast<std::uint32_t>(stream) + 0x632be5abu))) {}
+
+    constexpr std::uint32_t bits(std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0) const {
+        std::uint32_t h = mix(m_key ^ a * 0x8da6b343u);
+        h = mix(h ^ b * 0xd8163841u);
+        return mix(h ^ c * 0xcb1ab31fu);
+    }
+
+    // Uniform in [0, 1), 24 bits of precision
+    constexpr float uniform(std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0) const {
+        return static_cast<float>(bits(a, b, c) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform in [min, max)
+    constexpr float range(float min, float max, std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0) const {
+        return min + (max - min) * uniform(a, b, c);
+    }
+
+    // Vector forms of bits() and range() with the last counter varying per
+    // lane; lane i gives exactly the scalar result for c[i]
+    simd::vint bits(std::uint32_t a, std::uint32_t b, simd::vint c) const {
+        std::uint32_t h = mix(mix(m_key ^ a * 0x8da6b343u) ^ b * 0xd8163841u);
+        return mix(simd::set1i(static_cast<std::int32_t>(h)) ^ c * simd::set1i(static_cast<std::int32_t>(0xcb1ab31fu)));
+    }
+
+    simd::vfloat range(float min, float max, std::uint32_t a, std::uint32_t b, simd::vint c) const {
+        simd::vfloat u = simd::toFloat(simd::shiftRight<8>(bits(a, b, c))) * simd::set1(1.0f / 16777216.0f);
+        return simd::set1(min) + simd::set1(max - min) * u;
+    }
+
+    // 32-bit integer finaliser (lowbias32); every input bit affects every output bit
+    static constexpr std::uint32_t mix(std::uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    static simd::vint mix(simd::vint h) {
+        h = h ^ simd::shiftRight<16>(h);
+        h = h * simd::set1i(static_cast<std::int32_t>(0x7feb352du));
+        h = h ^ simd::shiftRight<15>(h);
+        h = h * simd::set1i(static_cast<std::int32_t>(0x846ca68bu));
+        return h ^ simd::shiftRight<16>(h);
+    }
+
+private:
+    std::uint32_t m_key;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix, for culling boxes on the CPU
+class Frustum {
+public:
+    explicit Frustum(const glm::mat4& viewProjection) {
+        // Gribb-Hartmann: each plane is the last row plus or minus another row.
+        // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+        auto row = [&](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+        glm::vec4 w = row(3);
+        for (int i = 0; i < 3; ++i) {
+            m_planes[2 * i] = w + row(i);
+            m_planes[2 * i + 1] = w - row(i);
+        }
+    }
+
+    // False only if the box is entirely outside one plane; boxes near a
+    // corner can pass without being visible, which is fine for culling
+    bool intersects(const glm::vec3& min, const glm::vec3& max) const {
+        for (const glm::vec4& plane : m_planes) {
+            // Corner furthest along the plane normal
+            glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+                             plane.y >= 0.0f ? max.y : min.y,
+                             plane.z >= 0.0f ? max.z : min.z);
+            if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 m_planes[6];
+};
@@ -11,7 +11,8 @@ public:
     void render();
 
 private:
-    void setupMatrices();
+    // Sets the matrix uniforms and returns projection * view * model
+    glm::mat4 setupMatrices();
 
     Camera& m_camera;
     Shader& m_shader;
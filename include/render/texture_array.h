@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU copy of a layered, fully mipmapped texture: what the asset cooker
+// writes to disk and what TextureCache uploads as one GL_TEXTURE_2D_ARRAY.
+// Every layer has the same square, power-of-two size.
+struct TextureArrayData {
+    enum class Format : std::uint32_t {
+        RGBA8 = 0,
+        BC1 = 1,    // 4x4 blocks of 8 bytes, opaque RGB
+    };
+
+    Format format = Format::RGBA8;
+    int size = 0;
+    int layers = 0;
+    // levels[i] holds every layer of mip i back to back, layer 0 first
+    std::vector<std::vector<unsigned char>> levels;
+
+    int levelSize(int level) const;
+    // Bytes of one layer at this level
+    std::size_t layerBytes(int level) const;
+};
+
+// Decodes the images, resamples each to size x size and builds the mip chain
+// down to 1x1. Throws if an image cannot be loaded or size is not a power of two.
+TextureArrayData buildTextureArray(const std::vector<std::string>& paths, int size);
+
+// Re-encodes every level of an RGBA8 array as BC1
+void compressBC1(TextureArrayData& data);
+
+// Cooked container: "TNTA", version, format, size, layers, level count, then
+// each level as a 64-bit byte count and its data. Little-endian.
+void writeTextureArray(const std::string& path, const TextureArrayData& data);
+// Returns false if the file does not exist; throws if it is not a valid container
+bool readTextureArray(const std::string& path, TextureArrayData& data);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Owns the GL texture arrays loaded from disk, one per cooked file. Terrains
+// ask for their materials by path and share the handles, so regenerating or
+// recreating a terrain never decodes or uploads an image twice.
+// Must be cleared while the GL context is still current.
+class TextureCache {
+public:
+    TextureCache() = default;
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // GL_TEXTURE_2D_ARRAY from a file written by the asset cooker, keyed by
+    // that file. If it is missing, has a different layer count, or uses a
+    // compression the driver lacks, the array is built from the source
+    // images instead (one per layer). If those fail to load too, every layer
+    // is a grey placeholder (and a message), and it is not retried.
+    GLuint getArray(const std::string& cookedPath, const std::vector<std::string>& sourcePaths,
+                    int layerSize = 512);
+    bool contains(const std::string& path) const;
+    std::size_t size() const;
+
+    // Deletes every texture; handles handed out before are invalid after this
+    void clear();
+
+private:
+    GLuint loadArray(const std::string& cookedPath, const std::vector<std::string>& sourcePaths,
+                     int layerSize) const;
+
+    std::unordered_map<std::string, GLuint> m_textures;
+};
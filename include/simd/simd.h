@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Minimal fixed-width float/int vectors for the terrain kernels.
+// Picks AVX2, SSE4.1 or NEON at compile time and falls back to one lane, so
+// a kernel written against these types builds everywhere and produces the
+// same per-lane results whatever the width.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TERRA_SIMD_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define TERRA_SIMD_SSE41
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TERRA_SIMD_NEON
+#endif
+
+namespace simd {
+
+#if defined(TERRA_SIMD_AVX2)
+
+constexpr int kWidth = 8;
+
+struct vfloat { __m256 v; };
+struct vint { __m256i v; };
+struct vmask { __m256 v; };
+
+inline vfloat load(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline void store(float* p, vfloat a) { _mm256_storeu_ps(p, a.v); }
+inline vfloat set1(float x) { return { _mm256_set1_ps(x) }; }
+inline vint load(const std::int32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+inline void store(std::int32_t* p, vint a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a.v); }
+inline vint set1i(std::int32_t x) { return { _mm256_set1_epi32(x) }; }
+
+inline vfloat operator+(vfloat a, vfloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline vfloat operator-(vfloat a, vfloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline vfloat operator*(vfloat a, vfloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline vfloat operator/(vfloat a, vfloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline vfloat min(vfloat a, vfloat b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline vfloat max(vfloat a, vfloat b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline vfloat floor(vfloat a) { return { _mm256_floor_ps(a.v) }; }
+inline vfloat sqrt(vfloat a) { return { _mm256_sqrt_ps(a.v) }; }
+inline vfloat abs(vfloat a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+
+inline vmask operator<(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline vmask operator>(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline vmask operator<=(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline vmask operator>=(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline vmask operator==(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+inline vmask operator&(vmask a, vmask b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline vmask operator|(vmask a, vmask b) { return { _mm256_or_ps(a.v, b.v) }; }
+// m ? a : b per lane
+inline vfloat select(vmask m, vfloat a, vfloat b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+inline bool any(vmask m) { return _mm256_movemask_ps(m.v) != 0; }
+
+inline vint toInt(vfloat a) { return { _mm256_cvttps_epi32(a.v) }; }
+inline vfloat toFloat(vint a) { return { _mm256_cvtepi32_ps(a.v) }; }
+inline vint operator+(vint a, vint b) { return { _mm256_add_epi32(a.v, b.v) }; }
+inline vint operator*(vint a, vint b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+inline vint operator^(vint a, vint b) { return { _mm256_xor_si256(a.v, b.v) }; }
+inline vint operator&(vint a, vint b) { return { _mm256_and_si256(a.v, b.v) }; }
+template <int N> inline vint shiftRight(vint a) { return { _mm256_srli_epi32(a.v, N) }; }
+
+#elif defined(TERRA_SIMD_SSE41)
+
+constexpr int kWidth = 4;
+
+struct vfloat { __m128 v; };
+struct vint { __m128i v; };
+struct vmask { __m128 v; };
+
+inline vfloat load(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void store(float* p, vfloat a) { _mm_storeu_ps(p, a.v); }
+inline vfloat set1(float x) { return { _mm_set1_ps(x) }; }
+inline vint load(const std::int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+inline void store(std::int32_t* p, vint a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+inline vint set1i(std::int32_t x) { return { _mm_set1_epi32(x) }; }
+
+inline vfloat operator+(vfloat a, vfloat b) { return { _mm_add_ps(a.v, b.v) }; }
+inline vfloat operator-(vfloat a, vfloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline vfloat operator*(vfloat a, vfloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline vfloat operator/(vfloat a, vfloat b) { return { _mm_div_ps(a.v, b.v) }; }
+inline vfloat min(vfloat a, vfloat b) { return { _mm_min_ps(a.v, b.v) }; }
+inline vfloat max(vfloat a, vfloat b) { return { _mm_max_ps(a.v, b.v) }; }
+inline vfloat floor(vfloat a) { return { _mm_floor_ps(a.v) }; }
+inline vfloat sqrt(vfloat a) { return { _mm_sqrt_ps(a.v) }; }
+inline vfloat abs(vfloat a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+inline vmask operator<(vfloat a, vfloat b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline vmask operator>(vfloat a, vfloat b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline vmask operator<=(vfloat a, vfloat b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline vmask operator>=(vfloat a, vfloat b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline vmask operator==(vfloat a, vfloat b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+inline vmask operator&(vmask a, vmask b) { return { _mm_and_ps(a.v, b.v) }; }
+inline vmask operator|(vmask a, vmask b) { return { _mm_or_ps(a.v, b.v) }; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return { _mm_blendv_ps(b.v, a.v, m.v) }; }
+inline bool any(vmask m) { return _mm_movemask_ps(m.v) != 0; }
+
+inline vint toInt(vfloat a) { return { _mm_cvttps_epi32(a.v) }; }
+inline vfloat toFloat(vint a) { return { _mm_cvtepi32_ps(a.v) }; }
+inline vint operator+(vint a, vint b) { return { _mm_add_epi32(a.v, b.v) }; }
+inline vint operator*(vint a, vint b) { return { _mm_mullo_epi32(a.v, b.v) }; }
+inline vint operator^(vint a, vint b) { return { _mm_xor_si128(a.v, b.v) }; }
+inline vint operator&(vint a, vint b) { return { _mm_and_si128(a.v, b.v) }; }
+template <int N> inline vint shiftRight(vint a) { return { _mm_srli_epi32(a.v, N) }; }
+
+#elif defined(TERRA_SIMD_NEON)
+
+constexpr int kWidth = 4;
+
+struct vfloat { float32x4_t v; };
+struct vint { int32x4_t v; };
+struct vmask { uint32x4_t v; };
+
+inline vfloat load(const float* p) { return { vld1q_f32(p) }; }
+inline void store(float* p, vfloat a) { vst1q_f32(p, a.v); }
+inline vfloat set1(float x) { return { vdupq_n_f32(x) }; }
+inline vint load(const std::int32_t* p) { return { vld1q_s32(p) }; }
+inline void store(std::int32_t* p, vint a) { vst1q_s32(p, a.v); }
+inline vint set1i(std::int32_t x) { return { vdupq_n_s32(x) }; }
+
+inline vfloat operator+(vfloat a, vfloat b) { return { vaddq_f32(a.v, b.v) }; }
+inline vfloat operator-(vfloat a, vfloat b) { return { vsubq_f32(a.v, b.v) }; }
+inline vfloat operator*(vfloat a, vfloat b) { return { vmulq_f32(a.v, b.v) }; }
+inline vfloat operator/(vfloat a, vfloat b) { return { vdivq_f32(a.v, b.v) }; }
+inline vfloat min(vfloat a, vfloat b) { return { vminq_f32(a.v, b.v) }; }
+inline vfloat max(vfloat a, vfloat b) { return { vmaxq_f32(a.v, b.v) }; }
+inline vfloat floor(vfloat a) { return { vrndmq_f32(a.v) }; }
+inline vfloat sqrt(vfloat a) { return { vsqrtq_f32(a.v) }; }
+inline vfloat abs(vfloat a) { return { vabsq_f32(a.v) }; }
+
+inline vmask operator<(vfloat a, vfloat b) { return { vcltq_f32(a.v, b.v) }; }
+inline vmask operator>(vfloat a, vfloat b) { return { vcgtq_f32(a.v, b.v) }; }
+inline vmask operator<=(vfloat a, vfloat b) { return { vcleq_f32(a.v, b.v) }; }
+inline vmask operator>=(vfloat a, vfloat b) { return { vcgeq_f32(a.v, b.v) }; }
+inline vmask operator==(vfloat a, vfloat b) { return { vceqq_f32(a.v, b.v) }; }
+inline vmask operator&(vmask a, vmask b) { return { vandq_u32(a.v, b.v) }; }
+inline vmask operator|(vmask a, vmask b) { return { vorrq_u32(a.v, b.v) }; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return { vbslq_f32(m.v, a.v, b.v) }; }
+inline bool any(vmask m) { return vmaxvq_u32(m.v) != 0; }
+
+inline vint toInt(vfloat a) { return { vcvtq_s32_f32(a.v) }; }
+inline vfloat toFloat(vint a) { return { vcvtq_f32_s32(a.v) }; }
+inline vint operator+(vint a, vint b) { return { vaddq_s32(a.v, b.v) }; }
+inline vint operator*(vint a, vint b) { return { vmulq_s32(a.v, b.v) }; }
+inline vint operator^(vint a, vint b) { return { veorq_s32(a.v, b.v) }; }
+inline vint operator&(vint a, vint b) { return { vandq_s32(a.v, b.v) }; }
+template <int N> inline vint shiftRight(vint a) {
+    return { vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a.v), N)) };
+}
+
+#else
+
+constexpr int kWidth = 1;
+
+struct vfloat { float v; };
+struct vint { std::int32_t v; };
+struct vmask { bool v; };
+
+inline vfloat load(const float* p) { return { *p }; }
+inline void store(float* p, vfloat a) { *p = a.v; }
+inline vfloat set1(float x) { return { x }; }
+inline vint load(const std::int32_t* p) { return { *p }; }
+inline void store(std::int32_t* p, vint a) { *p = a.v; }
+inline vint set1i(std::int32_t x) { return { x }; }
+
+inline vfloat operator+(vfloat a, vfloat b) { return { a.v + b.v }; }
+inline vfloat operator-(vfloat a, vfloat b) { return { a.v - b.v }; }
+inline vfloat operator*(vfloat a, vfloat b) { return { a.v * b.v }; }
+inline vfloat operator/(vfloat a, vfloat b) { return { a.v / b.v }; }
+// Same NaN/operand order as minps/maxps
+inline vfloat min(vfloat a, vfloat b) { return { a.v < b.v ? a.v : b.v }; }
+inline vfloat max(vfloat a, vfloat b) { return { a.v > b.v ? a.v : b.v }; }
+inline vfloat floor(vfloat a) { return { std::floor(a.v) }; }
+inline vfloat sqrt(vfloat a) { return { std::sqrt(a.v) }; }
+inline vfloat abs(vfloat a) { return { std::fabs(a.v) }; }
+
+inline vmask operator<(vfloat a, vfloat b) { return { a.v < b.v }; }
+inline vmask operator>(vfloat a, vfloat b) { return { a.v > b.v }; }
+inline vmask operator<=(vfloat a, vfloat b) { return { a.v <= b.v }; }
+inline vmask operator>=(vfloat a, vfloat b) { return { a.v >= b.v }; }
+inline vmask operator==(vfloat a, vfloat b) { return { a.v == b.v }; }
+inline vmask operator&(vmask a, vmask b) { return { a.v && b.v }; }
+inline vmask operator|(vmask a, vmask b) { return { a.v || b.v }; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return { m.v ? a.v : b.v }; }
+inline bool any(vmask m) { return m.v; }
+
+inline vint toInt(vfloat a) { return { static_cast<std::int32_t>(a.v) }; }
+inline vfloat toFloat(vint a) { return { static_cast<float>(a.v) }; }
+inline vint operator+(vint a, vint b) {
+    return { static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v) + static_cast<std::uint32_t>(b.v)) };
+}
+inline vint operator*(vint a, vint b) {
+    return { static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v) * static_cast<std::uint32_t>(b.v)) };
+}
+inline vint operator^(vint a, vint b) { return { a.v ^ b.v }; }
+inline vint operator&(vint a, vint b) { return { a.v & b.v }; }
+template <int N> inline vint shiftRight(vint a) {
+    return { static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v) >> N) };
+}
+
+#endif
+
+inline vfloat operator-(vfloat a) { return set1(0.0f) - a; }
+
+// Tail handling: move n < kWidth elements through a zero-padded scratch
+// vector, so the last few elements still take the vector code path
+inline vfloat loadPartial(const float* p, std::size_t n) {
+    alignas(32) float lanes[kWidth] = {};
+    std::copy(p, p + n, lanes);
+    return load(lanes);
+}
+
+inline void storePartial(float* p, vfloat a, std::size_t n) {
+    alignas(32) float lanes[kWidth];
+    store(lanes, a);
+    std::copy(lanes, lanes + n, p);
+}
+
+// Full or partial vector access picked at compile time, so one kernel body
+// serves both the main loop and the tail
+template <bool Partial>
+inline vfloat loadLanes(const float* p, std::size_t n) {
+    if constexpr (Partial) {
+        return loadPartial(p, n);
+    } else {
+        return load(p);
+    }
+}
+
+template <bool Partial>
+inline void storeLanes(float* p, vfloat a, std::size_t n) {
+    if constexpr (Partial) {
+        storePartial(p, a, n);
+    } else {
+        store(p, a);
+    }
+}
+
+// Runs kernel(i, n, partial) over [0, count) one vector at a time; `partial`
+// is std::true_type only for the last, short vector
+template <class Kernel>
+inline void forEachLane(int count, Kernel&& kernel) {
+    int i = 0;
+    for (; i + kWidth <= count; i += kWidth) {
+        kernel(i, static_cast<std::size_t>(kWidth), std::false_type());
+    }
+    if (i < count) {
+        kernel(i, static_cast<std::size_t>(count - i), std::true_type());
+    }
+}
+
+// start, start + 1, ... across the lanes
+inline vfloat iota(float start) {
+    alignas(32) float lanes[kWidth];
+    for (int i = 0; i < kWidth; ++i) {
+        lanes[i] = start + static_cast<float>(i);
+    }
+    return load(lanes);
+}
+
+}
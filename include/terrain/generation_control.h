@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+// Thrown out of a generation run that has been cancelled
+class GenerationCancelled : public std::runtime_error {
+public:
+    GenerationCancelled() : std::runtime_error("Terrain generation cancelled") {}
+};
+
+// Cancellation flag and progress shared by a generation run and its owner.
+// Generators poll it from their outer loops: parallel bodies only test
+// cancelled() and return early, the serial code between passes calls
+// checkpoint(), which throws once the run is cancelled.
+class GenerationControl {
+public:
+    GenerationControl() = default;
+    // Part of a parent run, such as one of several layers generated side by
+    // side: cancelling the parent cancels it, and its progress counts for
+    // `share` of the parent's current stage, so the shares should sum to 1
+    GenerationControl(GenerationControl& parent, float share) : m_parent(&parent), m_share(share) {}
+
+    GenerationControl(const GenerationControl&) = delete;
+    GenerationControl& operator=(const GenerationControl&) = delete;
+
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    bool cancelled() const {
+        return m_cancelled.load(std::memory_order_relaxed) || (m_parent && m_parent->cancelled());
+    }
+
+    // Overall progress in [0, 1]
+    float progress() const { return m_progress.load(std::memory_order_relaxed); }
+
+    // The part of the overall progress the next stage covers; only set
+    // between stages, never while a stage is reporting
+    void setRange(float begin, float end) {
+        m_begin = begin;
+        m_end = end;
+        m_stageDone.store(0.0f, std::memory_order_relaxed);
+        report(0.0f);
+    }
+
+    // Progress through the current stage; safe from any thread and never
+    // moves the overall progress backwards
+    void report(float fraction) {
+        float value = m_begin + (m_end - m_begin) * fraction;
+        float current = m_progress.load(std::memory_order_relaxed);
+        while (value > current) {
+            if (m_progress.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+                if (m_parent) {
+                    m_parent->addStageProgress((value - current) * m_share);
+                }
+                return;
+            }
+        }
+    }
+
+    // Throws once cancelled; a cancelled run reports nothing further
+    void checkpoint(float fraction) {
+        if (cancelled()) {
+            throw GenerationCancelled();
+        }
+        report(fraction);
+    }
+
+private:
+    // Children's progress adds up here rather than racing for the maximum
+    void addStageProgress(float delta) {
+        float done = m_stageDone.load(std::memory_order_relaxed);
+        while (!m_stageDone.compare_exchange_weak(done, done + delta, std::memory_order_relaxed)) {
+        }
+        report(std::min(done + delta, 1.0f));
+    }
+
+    GenerationControl* m_parent = nullptr;
+    float m_share = 1.0f;
+    std::atomic<float> m_stageDone{0.0f};
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<float> m_progress{0.0f};
+    float m_begin = 0.0f;
+    float m_end = 1.0f;
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Cache-line aligned allocator so every padded row starts on a 64 byte boundary
+template <class T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template <class U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+// Non-owning window into a HeightField (or any strided float grid).
+// Indexed as (x, z) like the old heightMap[x][z]; each x is one contiguous row.
+template <class T>
+class BasicHeightFieldView {
+public:
+    BasicHeightFieldView() = default;
+    BasicHeightFieldView(T* origin, int width, int height, std::ptrdiff_t stride)
+        : m_origin(origin), m_width(width), m_height(height), m_stride(stride) {}
+
+    // Allow HeightFieldView -> ConstHeightFieldView
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    BasicHeightFieldView(const BasicHeightFieldView<U>& other)
+        : m_origin(other.data()), m_width(other.width()), m_height(other.height()), m_stride(other.stride()) {}
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    std::ptrdiff_t stride() const { return m_stride; }
+    bool empty() const { return m_width <= 0 || m_height <= 0; }
+
+    T* data() const { return m_origin; }
+    T* row(int x) const { return m_origin + x * m_stride; }
+    T& operator()(int x, int z) const { return m_origin[x * m_stride + z]; }
+
+    BasicHeightFieldView subView(int x0, int z0, int width, int height) const {
+        return BasicHeightFieldView(m_origin + x0 * m_stride + z0, width, height, m_stride);
+    }
+
+private:
+    T* m_origin = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    std::ptrdiff_t m_stride = 0;
+};
+
+// Rectangular block of cells [x0, x1) x [z0, z1), the unit of parallel work
+struct TileRange {
+    int x0, x1;
+    int z0, z1;
+};
+
+using HeightFieldView = BasicHeightFieldView<float>;
+using ConstHeightFieldView = BasicHeightFieldView<const float>;
+
+// Flat, aligned 2D height grid replacing std::vector<std::vector<float>>.
+// Rows are padded to a multiple of 16 floats and the grid can carry a ghost
+// border of `border` cells on every side, addressable with negative indices.
+class HeightField {
+public:
+    static constexpr int kRowAlignment = 16; // floats (64 bytes)
+    // Tiles small enough that a tile's rows and scratch buffers stay in L1/L2
+    static constexpr int kTileSize = 64;
+
+    HeightField() = default;
+    HeightField(int width, int height, int border = 0, float value = 0.0f) {
+        resize(width, height, border, value);
+    }
+
+    void resize(int width, int height, int border = 0, float value = 0.0f) {
+        if (width < 0 || height < 0 || border < 0) {
+            throw std::runtime_error("HeightField dimensions must be non-negative");
+        }
+        m_width = width;
+        m_height = height;
+        m_border = border;
+        int paddedHeight = height + 2 * border;
+        m_stride = (paddedHeight + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+        m_storage.assign(static_cast<std::size_t>(width + 2 * border) * m_stride, value);
+        m_origin = m_storage.data() + border * m_stride + border;
+    }
+
+    HeightField(const HeightField& other) { *this = other; }
+    HeightField(HeightField&& other) noexcept { *this = std::move(other); }
+
+    HeightField& operator=(const HeightField& other) {
+        if (this != &other) {
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_border = other.m_border;
+            m_stride = other.m_stride;
+            m_storage = other.m_storage;
+            m_origin = m_storage.data() + m_border * m_stride + m_border;
+        }
+        return *this;
+    }
+
+    HeightField& operator=(HeightField&& other) noexcept {
+        if (this != &other) {
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_border = other.m_border;
+            m_stride = other.m_stride;
+            m_storage = std::move(other.m_storage);
+            m_origin = m_storage.empty() ? nullptr : m_storage.data() + m_border * m_stride + m_border;
+            other.m_width = other.m_height = other.m_border = 0;
+            other.m_stride = 0;
+            other.m_origin = nullptr;
+        }
+        return *this;
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int border() const { return m_border; }
+    std::ptrdiff_t stride() const { return m_stride; }
+    bool empty() const { return m_width == 0 || m_height == 0; }
+
+    // Pointer to cell (0, 0); rows are `stride()` floats apart
+    float* data() { return m_origin; }
+    const float* data() const { return m_origin; }
+
+    float* row(int x) { return m_origin + x * m_stride; }
+    const float* row(int x) const { return m_origin + x * m_stride; }
+
+    float& operator()(int x, int z) { return m_origin[x * m_stride + z]; }
+    const float& operator()(int x, int z) const { return m_origin[x * m_stride + z]; }
+
+    // Sets interior and ghost cells alike
+    void fill(float value) { std::fill(m_storage.begin(), m_storage.end(), value); }
+
+    // Copies the nearest interior value outwards into the ghost border
+    void clampBorder() {
+        if (m_border == 0 || empty()) return;
+        for (int x = 0; x < m_width; ++x) {
+            float* r = row(x);
+            for (int b = 1; b <= m_border; ++b) {
+                r[-b] = r[0];
+                r[m_height - 1 + b] = r[m_height - 1];
+            }
+        }
+        for (int b = 1; b <= m_border; ++b) {
+            std::copy(row(0) - m_border, row(0) + m_height + m_border, row(-b) - m_border);
+            std::copy(row(m_width - 1) - m_border, row(m_width - 1) + m_height + m_border,
+                      row(m_width - 1 + b) - m_border);
+        }
+    }
+
+    // Interior min/max, ignoring row padding and ghost cells
+    std::pair<float, float> minMax() const {
+        if (empty()) return {0.0f, 0.0f};
+        float lo = m_origin[0];
+        float hi = m_origin[0];
+        for (int x = 0; x < m_width; ++x) {
+            const float* r = row(x);
+            for (int z = 0; z < m_height; ++z) {
+                lo = std::min(lo, r[z]);
+                hi = std::max(hi, r[z]);
+            }
+        }
+        return {lo, hi};
+    }
+
+    // Splits the interior into tileSize x tileSize blocks, row-major
+    int tileCount(int tileSize = kTileSize) const {
+        return ((m_width + tileSize - 1) / tileSize) * ((m_height + tileSize - 1) / tileSize);
+    }
+
+    TileRange tile(int index, int tileSize = kTileSize) const {
+        int tilesZ = (m_height + tileSize - 1) / tileSize;
+        TileRange range;
+        range.x0 = (index / tilesZ) * tileSize;
+        range.z0 = (index % tilesZ) * tileSize;
+        range.x1 = std::min(range.x0 + tileSize, m_width);
+        range.z1 = std::min(range.z0 + tileSize, m_height);
+        return range;
+    }
+
+    HeightFieldView view() { return HeightFieldView(m_origin, m_width, m_height, m_stride); }
+    ConstHeightFieldView view() const { return ConstHeightFieldView(m_origin, m_width, m_height, m_stride); }
+
+    HeightFieldView subView(int x0, int z0, int width, int height) {
+        return view().subView(x0, z0, width, height);
+    }
+    ConstHeightFieldView subView(int x0, int z0, int width, int height) const {
+        return view().subView(x0, z0, width, height);
+    }
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_border = 0;
+    std::ptrdiff_t m_stride = 0;
+    float* m_origin = nullptr;
+    std::vector<float, AlignedAllocator<float>> m_storage;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// 64-bit FNV-1a hash of everything a generation stage's output depends on:
+// the keys of the stages feeding it plus its own parameters
+class StageKey {
+public:
+    template <class T>
+    StageKey& add(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "StageKey hashes raw bytes");
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (unsigned char byte : bytes) {
+            m_hash = (m_hash ^ byte) * 0x100000001b3ull;
+        }
+        return *this;
+    }
+
+    std::uint64_t value() const { return m_hash; }
+
+private:
+    std::uint64_t m_hash = 0xcbf29ce484222325ull;
+};
+
+// Remembers the key a stage last ran with
+class StageStamp {
+public:
+    // True, and remembers the key, if it differs from the last one
+    bool update(std::uint64_t key) {
+        if (m_valid && key == m_key) {
+            return false;
+        }
+        m_key = key;
+        m_valid = true;
+        return true;
+    }
+
+    void reset() { m_valid = false; }
+
+private:
+    std::uint64_t m_key = 0;
+    bool m_valid = false;
+};
+
+// Output of one stage, rebuilt only when its key changes
+template <class T>
+class CachedStage {
+public:
+    // build(T&) fills the output; if it throws, the stage stays dirty
+    template <class Build>
+    const T& get(std::uint64_t key, Build&& build) {
+        if (m_valid && key == m_key) {
+            return m_value;
+        }
+        m_valid = false;
+        std::forward<Build>(build)(m_value);
+        m_key = key;
+        m_valid = true;
+        return m_value;
+    }
+
+    void reset() { m_valid = false; }
+
+private:
+    T m_value{};
+    std::uint64_t m_key = 0;
+    bool m_valid = false;
+};
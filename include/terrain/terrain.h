@@ -5,27 +5,57 @@
 #include <memory>
 #include <stb/stb_image.h>
 #include <perlin_noise/PerlinNoise.hpp>
+#include <noise/cellular_noise.h>
 #include <load_shader/shader.h>
+#include <terrain/heightfield.h>
+#include <erosion/thermal_erosion.h>
+#include <erosion/hydraulic_erosion.h>
+#include <erosion/pipe_erosion.h>
+#include <random/counter_rng.h>
+#include <composite/compositor.h>
+#include <terrain/stage_cache.h>
+#include <terrain/generation_control.h>
+#include <render/texture_cache.h>
+#include <render/frustum.h>
+#include <future>
+#include <map>
+#include <optional>
 
 // Abstract base class for terrain generation algorithms
 class TerrainGenerator {
 public:
     virtual ~TerrainGenerator() = default;
-    virtual void generateHeightMap(std::vector<std::vector<float>>& heightMap) = 0;
+    virtual void generateHeightMap(HeightField& heightMap) = 0;
+
+    // Optional; lets a background run follow progress and cancel
+    void setControl(GenerationControl* control) { m_control = control; }
+
+protected:
+    bool cancelled() const { return m_control && m_control->cancelled(); }
+    void report(float fraction) const { if (m_control) m_control->report(fraction); }
+    void checkpoint(float fraction) const { if (m_control) m_control->checkpoint(fraction); }
+
+private:
+    GenerationControl* m_control = nullptr;
 };
 
 // Perlin noise terrain generator
 class PerlinNoiseGenerator : public TerrainGenerator {
 public:
-    PerlinNoiseGenerator(float frequency = 0.1f, int octaves = 5, float persistence = 0.5f);
-    void generateHeightMap(std::vector<std::vector<float>>& heightMap) override;
+    PerlinNoiseGenerator(float frequency = 0.1f, int octaves = 5, float persistence = 0.5f,
+                         unsigned int seed = 12345);
+    void generateHeightMap(HeightField& heightMap) override;
 
 private:
+    void generateTile(HeightField& heightMap, const TileRange& tile);
+
     float m_frequency;
     int m_octaves;
     float m_persistence;
     unsigned int m_seed;
-    siv::PerlinNoise perlin;
+    siv::PerlinNoiseF perlin;
+    CellularNoise cellular;
+    ThermalErosion m_erosion;
 };
 
 // Fault formation terrain generator
@@ -40,47 +70,98 @@ class FaultFormationGenerator : public TerrainGenerator {
         
     private:
         TerrainType m_terrainType;
+        CounterRng m_rng;
         
         // FastNoiseLite wrapper class
         class NoiseGenerator {
         private:
             int m_seed;
+            siv::PerlinNoiseF m_perlin;
         public:
             NoiseGenerator(int seed = 42);
             void setSeed(int seed);
-            float getNoise(float x, float y);
-            float getOctaveNoise(float x, float y, int octaves, float persistence);
+            int getSeed() const;
+            float getNoise(float x, float y) const;
+            float getOctaveNoise(float x, float y, int octaves, float persistence) const;
+            // Batched variants: out[i] = noise(xs[i], ys[i])
+            void getNoise(const float* xs, const float* ys, float* out, size_t count) const;
+            void getOctaveNoise(const float* xs, const float* ys, float* out, size_t count,
+                                int octaves, float persistence) const;
         };
         
-        NoiseGenerator m_noise;
+        NoiseGenerator m_noise;         // fault perturbation and falloff
+        NoiseGenerator m_detailNoise;   // addDetailNoise
+        ThermalErosion m_erosion;
+
+        // Reseed the perturbation and falloff fields for every fault
+        bool m_perIterationNoise = false;
+        std::vector<NoiseGenerator> m_faultNoise;
+
+        // Distance perturbation and falloff width per cell, shared by all faults
+        // and kept until the map size or seed changes
+        HeightField m_perturbation;
+        HeightField m_falloff;
+        int m_fieldSeed = 0;
         
         float calculateDisplacement(float iteration, float totalIterations);
         std::pair<glm::vec2, glm::vec2> generateFaultPoints(int width, int height, float iteration);
-        void createFault(std::vector<std::vector<float>>& heightMap, float iteration);
-        void applySimpleErosion(std::vector<std::vector<float>>& heightMap, int iterations);
-        void addDetailNoise(std::vector<std::vector<float>>& heightMap, float intensity);
-        void smoothTerrain(std::vector<std::vector<float>>& heightMap);
+        // One fault line; a * x + b * z + c is the signed distance from it
+        struct FaultLine {
+            float a, b, c;
+            float displacement;
+        };
+
+        FaultLine makeFault(int width, int height, float iteration);
+        void buildNoiseFields(int width, int height);
+        void sampleNoiseFields(const NoiseGenerator& noise, int x, int z0, int span, float falloffDistance,
+                               float* perturb, float* falloff) const;
+        void applyFaults(HeightField& heightMap, const TileRange& tile, const std::vector<FaultLine>& faults);
+        void addDetailNoise(HeightField& heightMap, float intensity);
+        void smoothTerrain(HeightField& heightMap);
 
         
     public:
-        FaultFormationGenerator(int iterations, float minDelta, float maxDelta);
+        FaultFormationGenerator(int iterations, float minDelta, float maxDelta, unsigned int seed = 12345);
         void setTerrainType(TerrainType type);
-        void generateHeightMap(std::vector<std::vector<float>>& heightMap) override;
+        // Fault perturbation seeded per fault (seed + i * 1000) instead of one
+        // shared field; much slower, since nothing can be cached
+        void setPerIterationNoise(bool enabled);
+        void generateHeightMap(HeightField& heightMap) override;
     };
 
 class MidpointDisplacementGenerator : public TerrainGenerator {
 public:
-    MidpointDisplacementGenerator(float roughness = 0.9f, float initialDisplacement = 0.8f);
-    void generateHeightMap(std::vector<std::vector<float>>& heightMap) override;
+    MidpointDisplacementGenerator(float roughness = 0.9f, float initialDisplacement = 0.8f,
+                                  unsigned int seed = 12345);
+    void generateHeightMap(HeightField& heightMap) override;
 
 private:
+    // Only the kTileSize x kTileSize tiles covering the map are generated.
+    // Their corners come from a coarse lattice one point per tile, and the
+    // finer levels run level by level across all of the tiles together.
+    static constexpr int kTileSize = 128;
+
+    // Where a grid sits on the map: grid (x, z) is map
+    // (x0 + x * spacing, z0 + z * spacing). Offsets are hashed from map
+    // coordinates, so every grid covering a point draws the same offset.
+    struct Lattice {
+        int x0, z0;
+        int spacing;
+    };
+
     float m_roughness;
     float m_initialDisplacement;
+    CounterRng m_rng;
     int calcNextPowerOfTwo(int size);
-    float randomFloatRange(float min, float max);
-    void diamondStep(std::vector<std::vector<float>>& heightMap, int size, float displacement);
-    void squareStep(std::vector<std::vector<float>>& heightMap, int size, float displacement);
-    float getAverageHeight(const std::vector<std::vector<float>>& heightMap, int x, int z, int size);
+    // Offset for cell (x, z) in the pass with the given rectangle size
+    float randomFloatRange(float min, float max, int rectSize, int x, int z) const;
+    // One level of diamond and square steps, in row bands on the thread pool,
+    // on a grid whose sides are multiples of rectSize plus one
+    void subdivide(HeightField& grid, int rectSize, float curHeight, const Lattice& lattice) const;
+    // Diamond or square updates of a single row within one level
+    void diamondRow(HeightField& grid, int x, int rectSize, float curHeight, const Lattice& lattice) const;
+    void squareRow(HeightField& grid, int x, int rectSize, float curHeight, const Lattice& lattice) const;
+    float getAverageHeight(const HeightField& heightMap, int x, int z, int size);
     
 };
 
@@ -99,63 +180,209 @@ public:
             int width, int height,
             int octaves, float persistence, float frequency,
             int iterations, float minDelta, float maxDelta,
-            float roughness, float initialDisplacement);
+            float roughness, float initialDisplacement,
+            int erosionDroplets = 0, int erosionSteps = 0,
+            unsigned int seed = 12345);
     ~Terrain();
 
-    void initTexture(Shader& shader, const std::vector<const char*>& texturePaths);
+    // Takes the material texture array from the cache (loading the cooked
+    // file, or the images one per layer, on first use) and points the
+    // shader's samplers at it and at the height texture. The cache keeps
+    // ownership of the materials.
+    void initTexture(Shader& shader, TextureCache& textures, const std::string& cookedPath,
+                     const std::vector<std::string>& texturePaths);
+
+    // Generation runs as a chain of cached stages: generator output (per
+    // type) -> erosion or composite -> height texture. Each stage is keyed
+    // by a hash of its parameters and the keys feeding it, so after a setter
+    // only the stages below the changed parameter run again.
+    //
+    // Runs happen on a worker thread with a snapshot of the settings. A
+    // request made while a run is in flight cancels it and starts again once
+    // it has stopped, so a burst of requests costs one extra run at most.
+    // poll() has to be called on the GL thread every frame: it uploads a
+    // finished run in one go, and the previous terrain is drawn until then.
+    void requestTerrain(GenerationType type);
+    // Runs every generator concurrently and blends the layers with the compositor
+    void requestAddedTerrain();
+    // Returns true when a new terrain was swapped in
+    bool poll();
+    // Cancels the running and pending runs and waits for the worker to stop
+    void stopGeneration();
+    bool isGenerating() const;
+    float getProgress() const;
+
+    // Blocking versions of the requests
     void generateTerrain(GenerationType type);
     void addedTerrain();
-    void render() const;
+
+    // Setters only affect the next request
+    void setCompositor(const Compositor& compositor);
+    void setPerlinParams(float frequency, int octaves, float persistence);
+    void setFaultParams(int iterations, float minDelta, float maxDelta);
+    void setMidpointParams(float roughness, float initialDisplacement);
+    void setErosion(int droplets, int steps);
+    void setSeed(unsigned int seed);
+    // Apply immediately; no regeneration needed. Vertices hold the raw
+    // heights and terrain.vert applies height * yScale - yShift.
+    void setHeightScale(float yScale, float yShift);
+    // Without level of detail, draws every resolution-th row and column of
+    // each chunk (plus its last ones, so chunks still meet)
+    void setResolution(int resolution);
+    // Level of detail (CDLOD): a quadtree over the chunks picks, per node, a
+    // spacing of 2^level cells so no patch quad covers more than pixelError
+    // pixels on screen. Vertices morph towards the next coarser level near
+    // the edge of their range, so levels meet without cracks or pops and the
+    // triangle count barely depends on the map size.
+    void setLevelOfDetail(bool enabled, float pixelError);
+
+    // The map is drawn as patches of kChunkSize x kChunkSize quads: one per
+    // chunk, or one per selected quadtree node with level of detail. Patches
+    // outside the frustum are skipped and the rest go out nearest first as
+    // instances of one shared grid. terrain.vert assumes the same size.
+    static constexpr int kChunkSize = 64;
+    // pixelsPerUnit is the viewport height / (2 tan(fovY / 2)): the on-screen
+    // size of one world unit at distance 1
+    void render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float pixelsPerUnit) const;
+    // Patches and triangles drawn by the last render()
+    int getDrawnPatches() const;
+    int getDrawnTriangles() const;
     float getYScale() const; 
     float getYShift() const; 
     float getheightMin() const;
     float getheightMax() const;    
+    unsigned int getSeed() const;
 
 private:
-    // OpenGL buffers
-    GLuint m_VAO, m_VBO, m_IBO;
+    // Everything a generation run depends on
+    struct Settings {
+        // Perlin Noise
+        int octaves;
+        float persistence, frequency;
+
+        //Fault Formation
+        int iterations;
+        float minDelta, maxDelta;
+
+        //midpoint displacement
+        float roughness;
+        float initialDisplacement;
+
+        // Hydraulic erosion, run on the output of every generator
+        int erosionDroplets;
+        int erosionSteps;
+
+        // Same seed and parameters always give the same map
+        unsigned int seed;
+
+        Compositor compositor;
+    };
+
+    struct Request {
+        GenerationType type;
+        bool layered;
+    };
+
+    // What a finished run changed, applied on the GL thread. heights points
+    // into a stage cache, which the worker leaves alone until the next run.
+    struct MeshUpdate {
+        const HeightField* heights = nullptr;
+        float heightMin = 0.0f;
+        float heightMax = 0.0f;
+        // Unscaled height range of every quadtree node: level 0 is the
+        // chunks, each level above merges 2x2 nodes, all row-major
+        std::vector<std::vector<std::pair<float, float>>> nodeHeights;
+    };
+
+    // One patch as a single triangle strip (rows joined by degenerate
+    // triangles) in 16-bit chunk-local indices, shared by every chunk
+    struct IndexLevel {
+        GLuint buffer = 0;
+        GLsizei count = 0;
+        int triangles = 0;
+    };
+
+    // Fraction of a level's distance band before its patches start morphing
+    static constexpr float kMorphStart = 0.7f;
+
+    // Per-instance attributes of the patch: map cell of its corner, cell
+    // spacing and the distances over which it morphs to the next level
+    struct PatchInstance {
+        float x0, z0;
+        float spacing;
+        float morphStart, morphEnd;
+    };
+
+    // OpenGL objects. The only vertex data is m_instanceBuffer: terrain.vert
+    // takes the patch-local vertex from gl_VertexID and samples its height
+    // from m_heightTexture (R32F, one texel per sample, bound to unit 1).
+    GLuint m_VAO;
+    GLuint m_instanceBuffer = 0;
+    GLuint m_heightTexture = 0;
+    int m_textureRows = 0;
+    int m_textureColumns = 0;
+    int m_chunkRows = 0;
+    int m_chunkColumns = 0;
+    std::vector<std::vector<std::pair<float, float>>> m_nodeHeights;
+    bool m_lodEnabled = true;
+    float m_lodPixelError = 4.0f;
+    mutable int m_drawnPatches = 0;
+    mutable int m_drawnTriangles = 0;
     
     int m_width, m_height;
 
+    // State of the terrain being drawn; heights are unscaled
     float m_heightMin = 0.0f;  
     float m_heightMax = 0.0f;  
-
-    // Perlin Noise
     int m_resolution;
-    int m_numStrips;
-    int m_numTrisPerStrip;
-    int m_octaves;
-    float m_persistence,m_frequency;
+
+    // Chunk index buffers by stride; they depend on neither the heights nor
+    // the map size, so they are built once
+    std::map<int, IndexLevel> m_indexLevels;
     float m_yScale;
     float m_yShift;
 
-    //Fault Formation
-    int m_iterations;
-    float m_minDelta, m_maxDelta;
-
-    //midpoint displacement
-    float m_roughness;
-    float m_initialDisplacement;    
+    // Settings for the next request
+    Settings m_settings;
 
-    // Data storage
-    std::vector<float> m_vertexArray;
-    std::vector<unsigned int> m_indices;
-    std::vector<std::vector<float>> heightMap;
-    std::vector<std::vector<float>> currentHeightMap;
-    std::vector<std::vector<std::vector<float>>> heightMaps;
+    // Background run; everything below it belongs to the worker while it runs
+    std::future<MeshUpdate> m_job;
+    std::shared_ptr<GenerationControl> m_control;
+    std::optional<Request> m_pending;
 
-    // Terrain generators
-    std::unique_ptr<TerrainGenerator> m_currentGenerator;
-    
+    // Material texture array, owned by the TextureCache; bound to unit 0
+    GLuint m_materials = 0;
 
-    void addMaps();
-    void maxMaps();
-    void weightedAddMaps();    
+    // Stage caches
+    CachedStage<HeightField> m_baseStage[static_cast<int>(GenerationType::COUNT)];
+    CachedStage<HeightField> m_erosionStage[static_cast<int>(GenerationType::COUNT)];
+    CachedStage<HeightField> m_compositeStage;
+    StageStamp m_heightStamp;
 
     // Internal methods
     void initializeGLBuffers();
-    void generateVertexArray(std::vector<std::vector<float>>& heightMap);
-    void generateIndices();
-    void setupBuffers();
-    void setTerrainGenerator(GenerationType type);
-};
\ No newline at end of file
+    // Builds and uploads the index buffer for a stride unless it is cached
+    void buildIndexLevel(int stride);
+    void clearIndexLevels();
+    // World-space bounds of quadtree node (i, j) at a level
+    void nodeBounds(int level, int i, int j, glm::vec3& lo, glm::vec3& hi) const;
+    // Adds the patches covering node (i, j), keyed by squared camera distance
+    void selectNode(int level, int i, int j, const Frustum& frustum, const glm::vec3& cameraPosition,
+                    const std::vector<float>& ranges, std::vector<std::pair<float, PatchInstance>>& patches) const;
+    void setupBuffers(const HeightField& heights);
+    // Copies [x0, x1) x [z0, z1) of the map into the height texture, which
+    // has to be the map's size already
+    void uploadHeights(const HeightField& heightMap, const TileRange& region);
+
+    void request(const Request& request);
+    void startJob(const Request& request);
+    MeshUpdate runJob(const Request& request, const Settings& settings, GenerationControl& control);
+    void waitForJobs();
+
+    std::uint64_t baseKey(GenerationType type, const Settings& settings) const;
+    const HeightField& baseLayer(GenerationType type, std::uint64_t key, const Settings& settings,
+                                 GenerationControl& control);
+    // Height texture and node bounds for the final height map
+    MeshUpdate buildMesh(const HeightField& heightMap, std::uint64_t key);
+    std::unique_ptr<TerrainGenerator> makeGenerator(GenerationType type, const Settings& settings) const;
+};
@@ -0,0 +1,150 @@
+#include <composite/compositor.h>
+#include <parallel/thread_pool.h>
+#include <simd/simd.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+Compositor::Compositor(Op op, std::vector<float> weights, float smoothness)
+    : m_op(op)
+    , m_weights(std::move(weights))
+    , m_smoothness(smoothness) {
+}
+
+void Compositor::setOp(Op op) {
+    m_op = op;
+}
+
+void Compositor::setWeights(std::vector<float> weights) {
+    m_weights = std::move(weights);
+}
+
+void Compositor::setSmoothness(float smoothness) {
+    m_smoothness = smoothness;
+}
+
+Compositor::Op Compositor::getOp() const {
+    return m_op;
+}
+
+const std::vector<float>& Compositor::getWeights() const {
+    return m_weights;
+}
+
+float Compositor::getSmoothness() const {
+    return m_smoothness;
+}
+
+template <class Combine>
+void Compositor::blendTile(HeightField& target, const std::vector<const HeightField*>& layers,
+                           const std::vector<float>& gains, float scale, const TileRange& tile,
+                           Combine combine) const {
+    using namespace simd;
+    const int span = tile.z1 - tile.z0;
+    const int layerCount = static_cast<int>(layers.size());
+
+    for (int x = tile.x0; x < tile.x1; ++x) {
+        float* out = target.row(x) + tile.z0;
+        // The accumulator stays in a register across all layers
+        forEachLane(span, [&](int i, std::size_t n, auto partial) {
+            constexpr bool kPartial = decltype(partial)::value;
+            vfloat acc = loadLanes<kPartial>(layers[0]->row(x) + tile.z0 + i, n) * set1(gains[0]);
+            for (int layer = 1; layer < layerCount; ++layer) {
+                vfloat value = loadLanes<kPartial>(layers[layer]->row(x) + tile.z0 + i, n) * set1(gains[layer]);
+                acc = combine(acc, value);
+            }
+            storeLanes<kPartial>(out + i, acc * set1(scale), n);
+        });
+    }
+}
+
+void Compositor::lerpTile(HeightField& target, const std::vector<const HeightField*>& layers,
+                          const std::vector<float>& gains, const TileRange& tile) const {
+    using namespace simd;
+    const int span = tile.z1 - tile.z0;
+
+    for (int x = tile.x0; x < tile.x1; ++x) {
+        const float* a = layers[0]->row(x) + tile.z0;
+        const float* b = layers[1]->row(x) + tile.z0;
+        const float* mask = layers[2]->row(x) + tile.z0;
+        float* out = target.row(x) + tile.z0;
+        forEachLane(span, [&](int i, std::size_t n, auto partial) {
+            constexpr bool kPartial = decltype(partial)::value;
+            vfloat va = loadLanes<kPartial>(a + i, n) * set1(gains[0]);
+            vfloat vb = loadLanes<kPartial>(b + i, n) * set1(gains[1]);
+            vfloat t = min(max(loadLanes<kPartial>(mask + i, n), set1(0.0f)), set1(1.0f));
+            storeLanes<kPartial>(out + i, va + (vb - va) * t, n);
+        });
+    }
+}
+
+void Compositor::apply(HeightField& target, const std::vector<const HeightField*>& layers) const {
+    if (layers.empty()) {
+        throw std::runtime_error("Compositor needs at least one layer");
+    }
+    if (m_op == Op::LERP_BY_MASK && layers.size() != 3) {
+        throw std::runtime_error("Mask blending takes exactly two layers and a mask");
+    }
+    for (const HeightField* layer : layers) {
+        if (!layer || layer->width() != target.width() || layer->height() != target.height()) {
+            throw std::runtime_error("Compositor layers must match the target size");
+        }
+    }
+
+    std::vector<float> gains(layers.size(), 1.0f);
+    std::copy_n(m_weights.begin(), std::min(m_weights.size(), gains.size()), gains.begin());
+
+    float scale = 1.0f;
+    if (m_op == Op::WEIGHTED) {
+        float total = 0.0f;
+        for (float gain : gains) {
+            total += gain;
+        }
+        if (total == 0.0f) {
+            throw std::runtime_error("Weighted blend needs weights that do not sum to zero");
+        }
+        scale = 1.0f / total;
+    }
+
+    const float k = m_smoothness;
+    ThreadPool::global().parallelFor(target.tileCount(), [&](int index) {
+        TileRange tile = target.tile(index);
+        switch (m_op) {
+            case Op::ADD:
+            case Op::WEIGHTED:
+                blendTile(target, layers, gains, scale, tile,
+                          [](simd::vfloat a, simd::vfloat b) { return a + b; });
+                break;
+            case Op::MAX:
+                blendTile(target, layers, gains, scale, tile,
+                          [](simd::vfloat a, simd::vfloat b) { return simd::max(a, b); });
+                break;
+            case Op::MIN:
+                blendTile(target, layers, gains, scale, tile,
+                          [](simd::vfloat a, simd::vfloat b) { return simd::min(a, b); });
+                break;
+            case Op::MULTIPLY:
+                blendTile(target, layers, gains, scale, tile,
+                          [](simd::vfloat a, simd::vfloat b) { return a * b; });
+                break;
+            case Op::SMOOTH_MAX:
+                if (k <= 0.0f) {
+                    blendTile(target, layers, gains, scale, tile,
+                              [](simd::vfloat a, simd::vfloat b) { return simd::max(a, b); });
+                    break;
+                }
+                // Polynomial smooth max: max(a, b) + k/4 * h^2, h = max(k - |a - b|, 0) / k
+                blendTile(target, layers, gains, scale, tile, [k](simd::vfloat a, simd::vfloat b) {
+                    simd::vfloat h = simd::max(simd::set1(k) - simd::abs(a - b), simd::set1(0.0f))
+                                   * simd::set1(1.0f / k);
+                    return simd::max(a, b) + h * h * simd::set1(0.25f * k);
+                });
+                break;
+            case Op::LERP_BY_MASK:
+                lerpTile(target, layers, gains, tile);
+                break;
+        }
+    });
+}
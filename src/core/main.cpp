@@ -12,6 +12,9 @@
 #include <imgui_impl_opengl3.h>
 #include <terrain/terrain.h>
 #include <render/render.h>
+#include <parallel/thread_pool.h>
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 
@@ -115,9 +118,31 @@ class TerraNarrative{
             terrainTypeChanged = ImGui::Combo("Terrain Type", &m_terrainType, m_terrainTypes, IM_ARRAYSIZE(m_terrainTypes));
             
             // Common parameters
-            paramsChanged |= ImGui::SliderFloat("Height Scale", &m_yScale, 4.0f, 16.0f, "%.3f");
-            paramsChanged |= ImGui::SliderFloat("Height Shift", &m_yShift, 0.0f, 32.0f, "%.1f");
-            paramsChanged |= ImGui::SliderInt("Resolution", &m_resolution, 1, 10);
+            // Applied in the vertex shader, so no regeneration
+            bool heightChanged = ImGui::SliderFloat("Height Scale", &m_yScale, 4.0f, 16.0f, "%.3f");
+            heightChanged |= ImGui::SliderFloat("Height Shift", &m_yShift, 0.0f, 32.0f, "%.1f");
+            if (heightChanged) {
+                m_terrain->setHeightScale(m_yScale, m_yShift);
+            }
+            // Picks a cached index buffer; also no regeneration
+            if (ImGui::SliderInt("Resolution", &m_resolution, 1, 10)) {
+                m_terrain->setResolution(m_resolution);
+            }
+
+            // Same seed and parameters always give the same map
+            paramsChanged |= ImGui::InputInt("Seed", &m_seed);
+
+            // Generators give identical output for any thread count
+            if (ImGui::SliderInt("Worker Threads", &m_workerThreads, 1, m_maxWorkerThreads)) {
+                // The pool can only be rebuilt while nothing is generating
+                m_terrain->stopGeneration();
+                ThreadPool::setGlobalThreadCount(m_workerThreads);
+                paramsChanged = true;
+            }
+            
+            paramsChanged |= ImGui::SliderInt("Erosion Droplets", &m_erosionDroplets, 0, 1000000, "%d",
+                                              ImGuiSliderFlags_Logarithmic);
+            paramsChanged |= ImGui::SliderInt("Erosion Steps", &m_erosionSteps, 0, 500);
             
             // Generator-specific parameters
             if (m_terrainType == PERLIN_NOISE) {
@@ -129,11 +154,6 @@ class TerraNarrative{
                 paramsChanged |= ImGui::SliderInt("Iterations", &m_faultIterations, 50, 500);
                 paramsChanged |= ImGui::SliderFloat("Min Delta", &m_faultMinDelta, 0.001f, 0.1f);
                 paramsChanged |= ImGui::SliderFloat("Max Delta", &m_faultMaxDelta, 0.1f, 0.5f);
-                
-                // Show current iteration during generation
-                if (m_currentIteration > 0) {
-                    ImGui::ProgressBar(static_cast<float>(m_currentIteration) / m_faultIterations);
-                }
             }
             else if (m_terrainType == MIDPOINT_DISPLACEMENT) {
                 paramsChanged |= ImGui::SliderFloat("Roughness", &m_roughness, 0.1f, 1.0f, "%.2f");
@@ -147,14 +167,14 @@ class TerraNarrative{
 
             // Add a generate button
             if (ImGui::Button("Generate Terrain") || paramsChanged || terrainTypeChanged) {
-                // Reset current iteration counter
-                m_currentIteration = 0;
-                
-                // Recreate terrain with new parameters
-                delete m_terrain;
-                initTerrain();
-                delete m_renderer;
-                initRenderer();
+                // Runs in the background; only the stages affected by the
+                // change run again
+                updateTerrain();
+            }
+
+            // Progress of the background run; the old terrain stays up until it is done
+            if (m_terrain->isGenerating()) {
+                ImGui::ProgressBar(m_terrain->getProgress());
             }
 
             // Camera info
@@ -167,6 +187,14 @@ class TerraNarrative{
             // Rendering options
             if (ImGui::CollapsingHeader("Render Settings")) {
                 ImGui::Checkbox("Wireframe Mode", &m_isWireframe);
+                // Coarser patches further away; Resolution applies with it off
+                bool lodChanged = ImGui::Checkbox("Level of Detail", &m_levelOfDetail);
+                lodChanged |= ImGui::SliderFloat("LOD Pixel Error", &m_lodPixelError, 1.0f, 16.0f, "%.1f");
+                if (lodChanged) {
+                    m_terrain->setLevelOfDetail(m_levelOfDetail, m_lodPixelError);
+                }
+                ImGui::Text("Patches drawn: %d (%d triangles)", m_terrain->getDrawnPatches(),
+                            m_terrain->getDrawnTriangles());
                 if (m_isWireframe) {
                     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
                 } else {
@@ -190,6 +218,9 @@ class TerraNarrative{
 
                 processInput(window);
 
+                // Swaps in a finished background run
+                m_terrain->poll();
+
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
                 m_renderer->render();
@@ -204,10 +235,13 @@ class TerraNarrative{
             }
             
             // Cleanup
+            m_terrain->stopGeneration();
             ImGui_ImplOpenGL3_Shutdown();
             ImGui_ImplGlfw_Shutdown();
             ImGui::DestroyContext();
             
+            // Textures have to go while the context is still alive
+            m_textures.clear();
             glfwDestroyWindow(window);
             glfwTerminate();                
         }
@@ -218,6 +252,7 @@ class TerraNarrative{
         Camera camera;
         Shader shader;
         Terrain* m_terrain = nullptr;
+        TextureCache m_textures;
         Renderer* m_renderer = nullptr;        
 
         bool m_cursorEnabled = false;
@@ -245,7 +280,11 @@ class TerraNarrative{
         int m_mapWidth = 300;
         int m_mapHeight = 300;
 
+        int m_maxWorkerThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        int m_workerThreads = m_maxWorkerThreads;
+
         int m_terrainType = 0;
+        int m_seed = 12345;
         const char* m_terrainTypes[3] = { 
             "Perlin Noise", 
             "Fault Formation",
@@ -262,6 +301,8 @@ class TerraNarrative{
         float m_yScale = 8.0f;
         float m_yShift = 4.0f;  
         int m_resolution = 1;
+        bool m_levelOfDetail = true;
+        float m_lodPixelError = 4.0f;
         float m_noiseFrequency = 0.015f;
         int m_noiseOctaves = 5;
         float m_noisePersistence = 0.5f;
@@ -269,20 +310,26 @@ class TerraNarrative{
         int m_faultIterations = 200;
         float m_faultMinDelta = 0.01f;
         float m_faultMaxDelta = 0.15f;
-        int m_currentIteration = 0;
 
 
         float m_roughness = 0.5f;
         float m_initialDisplacement = 1.0f;        
 
+        // Hydraulic erosion
+        int m_erosionDroplets = 0;
+        int m_erosionSteps = 0;
+
         float m_near  =  0.1f;
         float m_far   =  1000.0f;        
 
         const char* m_vertexShader = "../assets/shaders/terrain.vert";
         const char* m_fragShader = "../assets/shaders/terrain.frag";     
-        std::vector<const char*> m_texturePath = {"../assets/data/grass.jpg", 
-                                                    "../assets/data/stone.jpg",
-                                                    "../assets/data/snow.jpg"};
+        // Cooked into the build directory by the cook_assets target; the
+        // images are the fallback, one per layer
+        std::string m_materialArray = "assets/materials.tnta";
+        std::vector<std::string> m_texturePath = {"../assets/data/grass.jpg", 
+                                                  "../assets/data/stone.jpg",
+                                                  "../assets/data/snow.jpg"};
         
         GLuint m_VAO,m_VBO,m_IBO;
 
@@ -337,27 +384,12 @@ class TerraNarrative{
                     m_mapWidth, m_mapHeight, 
                     m_noiseOctaves, m_noisePersistence, m_noiseFrequency,
                     m_faultIterations, m_faultMinDelta, m_faultMaxDelta,
-                    m_roughness, m_initialDisplacement  // Add new parameters
+                    m_roughness, m_initialDisplacement,  // Add new parameters
+                    m_erosionDroplets, m_erosionSteps,
+                    static_cast<unsigned int>(m_seed)
                 );
-                m_terrain->initTexture(shader, m_texturePath);            
-                
-                // Map the terrain type to the corresponding generation type
-                Terrain::GenerationType genType;
-                switch(m_terrainType) {
-                    case PERLIN_NOISE:
-                        genType = Terrain::GenerationType::PERLIN_NOISE;
-                        break;
-                    case FAULT_FORMATION:
-                        genType = Terrain::GenerationType::FAULT_FORMATION;
-                        break;
-                    case MIDPOINT_DISPLACEMENT:
-                        genType = Terrain::GenerationType::MIDPOINT_DISPLACEMENT;
-                        break;
-                    default:
-                        throw std::runtime_error("Invalid terrain type");
-                }
-                
-                m_terrain->generateTerrain(genType);
+                m_terrain->initTexture(shader, m_textures, m_materialArray, m_texturePath);            
+                m_terrain->generateTerrain(generationType());
 
                 // m_terrain->addedTerrain();
             } catch (const std::runtime_error& e) {
@@ -366,6 +398,36 @@ class TerraNarrative{
             }
         }
 
+        void updateTerrain() {
+            try {
+                m_terrain->setHeightScale(m_yScale, m_yShift);
+                m_terrain->setResolution(m_resolution);
+                m_terrain->setSeed(static_cast<unsigned int>(m_seed));
+                m_terrain->setErosion(m_erosionDroplets, m_erosionSteps);
+                m_terrain->setPerlinParams(m_noiseFrequency, m_noiseOctaves, m_noisePersistence);
+                m_terrain->setFaultParams(m_faultIterations, m_faultMinDelta, m_faultMaxDelta);
+                m_terrain->setMidpointParams(m_roughness, m_initialDisplacement);
+                m_terrain->requestTerrain(generationType());
+            } catch (const std::runtime_error& e) {
+                std::cerr << "Failed to update terrain: " << e.what() << std::endl;
+                throw;
+            }
+        }
+
+        // Map the terrain type to the corresponding generation type
+        Terrain::GenerationType generationType() const {
+            switch(m_terrainType) {
+                case PERLIN_NOISE:
+                    return Terrain::GenerationType::PERLIN_NOISE;
+                case FAULT_FORMATION:
+                    return Terrain::GenerationType::FAULT_FORMATION;
+                case MIDPOINT_DISPLACEMENT:
+                    return Terrain::GenerationType::MIDPOINT_DISPLACEMENT;
+                default:
+                    throw std::runtime_error("Invalid terrain type");
+            }
+        }
+
         void initShaders(){
             shader = Shader(m_vertexShader,m_fragShader);                        
         }
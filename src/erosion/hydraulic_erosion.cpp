@@ -0,0 +1,259 @@
+#include <erosion/hydraulic_erosion.h>
+#include <parallel/thread_pool.h>
+#include <random/counter_rng.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+HydraulicErosion::HydraulicErosion(int droplets, std::uint32_t seed)
+    : m_droplets(droplets)
+    , m_seed(seed) {
+    buildBrush();
+}
+
+void HydraulicErosion::setDroplets(int droplets) {
+    m_droplets = droplets;
+}
+
+void HydraulicErosion::setSeed(std::uint32_t seed) {
+    m_seed = seed;
+}
+
+void HydraulicErosion::setLifetime(int steps) {
+    m_lifetime = std::max(1, steps);
+}
+
+void HydraulicErosion::setBrushRadius(int radius) {
+    m_brushRadius = std::max(0, radius);
+    buildBrush();
+}
+
+int HydraulicErosion::getDroplets() const {
+    return m_droplets;
+}
+
+void HydraulicErosion::buildBrush() {
+    m_brushX.clear();
+    m_brushZ.clear();
+    m_brushWeight.clear();
+
+    float total = 0.0f;
+    for (int dx = -m_brushRadius; dx <= m_brushRadius; ++dx) {
+        for (int dz = -m_brushRadius; dz <= m_brushRadius; ++dz) {
+            float dist = std::sqrt(static_cast<float>(dx * dx + dz * dz));
+            float weight = std::max(0.0f, m_brushRadius + 0.5f - dist);
+            if (weight <= 0.0f) continue;
+            m_brushX.push_back(dx);
+            m_brushZ.push_back(dz);
+            m_brushWeight.push_back(weight);
+            total += weight;
+        }
+    }
+    for (float& weight : m_brushWeight) {
+        weight /= total;
+    }
+}
+
+int HydraulicErosion::tileSize() const {
+    // A droplet moves one cell per step; its brush, deposit corners and
+    // bilinear reads reach a little further than its position
+    int reach = m_lifetime + m_brushRadius + 2;
+    return std::max(HeightField::kTileSize, 2 * reach);
+}
+
+void HydraulicErosion::apply(HeightField& heightMap, GenerationControl* control) const {
+    int width = heightMap.width();
+    int height = heightMap.height();
+    if (m_droplets <= 0 || width < 2 || height < 2) {
+        return;
+    }
+
+    const int size = tileSize();
+    const int tilesZ = (height + size - 1) / size;
+    const int tileCount = heightMap.tileCount(size);
+    const double dropletsPerCell = static_cast<double>(m_droplets) / (static_cast<double>(width) * height);
+
+    // Checkerboard colours: same-coloured tiles are a whole tile apart
+    ThreadPool& pool = ThreadPool::global();
+    for (int colour = 0; colour < 4; ++colour) {
+        if (control) {
+            control->checkpoint(colour / 4.0f);
+        }
+        std::vector<int> tiles;
+        for (int i = 0; i < tileCount; ++i) {
+            int tx = i / tilesZ;
+            int tz = i % tilesZ;
+            if ((tx % 2) + 2 * (tz % 2) == colour) {
+                tiles.push_back(i);
+            }
+        }
+
+        pool.parallelFor(static_cast<int>(tiles.size()), [&](int k) {
+            if (control && control->cancelled()) {
+                return;
+            }
+            int index = tiles[k];
+            TileRange tile = heightMap.tile(index, size);
+            double area = static_cast<double>(tile.x1 - tile.x0) * (tile.z1 - tile.z0);
+            int droplets = static_cast<int>(std::lround(dropletsPerCell * area));
+            simulateTile(heightMap, tile, index, droplets);
+        });
+    }
+    // Tiles skipped after a cancel leave the map half eroded
+    if (control) {
+        control->checkpoint(1.0f);
+    }
+}
+
+namespace {
+struct HeightAndGradient {
+    float height;
+    float gradientX;
+    float gradientZ;
+};
+
+// Bilinear height and slope at a position strictly inside the map
+HeightAndGradient sampleHeight(const HeightField& heightMap, float posX, float posZ) {
+    int cellX = static_cast<int>(posX);
+    int cellZ = static_cast<int>(posZ);
+    float u = posX - cellX;
+    float v = posZ - cellZ;
+
+    const float* row0 = heightMap.row(cellX);
+    const float* row1 = heightMap.row(cellX + 1);
+    float h00 = row0[cellZ];
+    float h01 = row0[cellZ + 1];
+    float h10 = row1[cellZ];
+    float h11 = row1[cellZ + 1];
+
+    HeightAndGradient result;
+    result.gradientX = (h10 - h00) * (1.0f - v) + (h11 - h01) * v;
+    result.gradientZ = (h01 - h00) * (1.0f - u) + (h11 - h10) * u;
+    result.height = h00 * (1.0f - u) * (1.0f - v) + h10 * u * (1.0f - v) + h01 * (1.0f - u) * v + h11 * u * v;
+    return result;
+}
+
+// Spreads an amount over the four cells around a position
+void depositAt(HeightField& heightMap, float posX, float posZ, float amount) {
+    int cellX = static_cast<int>(posX);
+    int cellZ = static_cast<int>(posZ);
+    float u = posX - cellX;
+    float v = posZ - cellZ;
+
+    float* row0 = heightMap.row(cellX);
+    float* row1 = heightMap.row(cellX + 1);
+    row0[cellZ] += amount * (1.0f - u) * (1.0f - v);
+    row1[cellZ] += amount * u * (1.0f - v);
+    row0[cellZ + 1] += amount * (1.0f - u) * v;
+    row1[cellZ + 1] += amount * u * v;
+}
+}
+
+void HydraulicErosion::simulateTile(HeightField& heightMap, const TileRange& tile, int tileIndex,
+                                    int droplets) const {
+    int width = heightMap.width();
+    int height = heightMap.height();
+    if (tile.x0 >= width - 1 || tile.z0 >= height - 1) {
+        return;
+    }
+
+    // Droplets are stepped in lockstep batches with their state kept as
+    // separate arrays, one slot per droplet
+    const int batchSize = 64;
+    std::vector<float> posX(batchSize), posZ(batchSize);
+    std::vector<float> dirX(batchSize), dirZ(batchSize);
+    std::vector<float> speed(batchSize), water(batchSize), sediment(batchSize);
+    std::vector<unsigned char> alive(batchSize);
+
+    // Spawn anywhere in the tile that still has a cell to interpolate towards;
+    // droplet d of tile t always starts at the same place
+    const CounterRng rng(m_seed, RngStream::EROSION_DROPLETS);
+    const float spawnX0 = static_cast<float>(tile.x0);
+    const float spawnX1 = static_cast<float>(std::min(tile.x1, width - 1));
+    const float spawnZ0 = static_cast<float>(tile.z0);
+    const float spawnZ1 = static_cast<float>(std::min(tile.z1, height - 1));
+    // The float range can round up to its upper bound
+    const float lastX = std::nextafter(static_cast<float>(width - 1), 0.0f);
+    const float lastZ = std::nextafter(static_cast<float>(height - 1), 0.0f);
+    const int brushCells = static_cast<int>(m_brushWeight.size());
+
+    for (int first = 0; first < droplets; first += batchSize) {
+        int count = std::min(batchSize, droplets - first);
+        for (int i = 0; i < count; ++i) {
+            int droplet = first + i;
+            posX[i] = std::min(rng.range(spawnX0, spawnX1, tileIndex, droplet, 0), lastX);
+            posZ[i] = std::min(rng.range(spawnZ0, spawnZ1, tileIndex, droplet, 1), lastZ);
+            dirX[i] = 0.0f;
+            dirZ[i] = 0.0f;
+            speed[i] = initialSpeed;
+            water[i] = initialWater;
+            sediment[i] = 0.0f;
+            alive[i] = 1;
+        }
+
+        for (int step = 0; step < m_lifetime; ++step) {
+            for (int i = 0; i < count; ++i) {
+                if (!alive[i]) continue;
+
+                float startX = posX[i];
+                float startZ = posZ[i];
+                int cellX = static_cast<int>(startX);
+                int cellZ = static_cast<int>(startZ);
+
+                // Roll downhill, keeping a little of the previous direction
+                HeightAndGradient here = sampleHeight(heightMap, startX, startZ);
+                dirX[i] = dirX[i] * inertia - here.gradientX * (1.0f - inertia);
+                dirZ[i] = dirZ[i] * inertia - here.gradientZ * (1.0f - inertia);
+                float length = std::sqrt(dirX[i] * dirX[i] + dirZ[i] * dirZ[i]);
+                if (length == 0.0f) {
+                    alive[i] = 0;
+                    continue;
+                }
+                dirX[i] /= length;
+                dirZ[i] /= length;
+                posX[i] += dirX[i];
+                posZ[i] += dirZ[i];
+
+                // Droplets leaving the map take their sediment with them
+                if (posX[i] < 0.0f || posX[i] >= width - 1 || posZ[i] < 0.0f || posZ[i] >= height - 1) {
+                    alive[i] = 0;
+                    continue;
+                }
+
+                float deltaHeight = sampleHeight(heightMap, posX[i], posZ[i]).height - here.height;
+                float capacity = std::max(-deltaHeight * speed[i] * water[i] * sedimentCapacity, minSedimentCapacity);
+
+                if (sediment[i] > capacity || deltaHeight > 0.0f) {
+                    // Uphill: fill the pit behind us; otherwise drop the excess
+                    float deposit = deltaHeight > 0.0f ? std::min(deltaHeight, sediment[i])
+                                                       : (sediment[i] - capacity) * depositSpeed;
+                    sediment[i] -= deposit;
+
+                    depositAt(heightMap, startX, startZ, deposit);
+                } else {
+                    // Erode at most the drop, so the droplet never digs a pit
+                    float erode = std::min((capacity - sediment[i]) * erodeSpeed, -deltaHeight);
+                    for (int b = 0; b < brushCells; ++b) {
+                        int x = cellX + m_brushX[b];
+                        int z = cellZ + m_brushZ[b];
+                        if (x < 0 || x >= width || z < 0 || z >= height) continue;
+                        float amount = erode * m_brushWeight[b];
+                        heightMap(x, z) -= amount;
+                        sediment[i] += amount;
+                    }
+                }
+
+                speed[i] = std::sqrt(std::max(0.0f, speed[i] * speed[i] + deltaHeight * gravity));
+                water[i] *= (1.0f - evaporateSpeed);
+            }
+        }
+
+        // Droplets that ran out of steps or stopped on flat ground drop what they carry
+        for (int i = 0; i < count; ++i) {
+            if (sediment[i] <= 0.0f) continue;
+            if (posX[i] < 0.0f || posX[i] >= width - 1 || posZ[i] < 0.0f || posZ[i] >= height - 1) continue;
+            depositAt(heightMap, posX[i], posZ[i], sediment[i]);
+        }
+    }
+}
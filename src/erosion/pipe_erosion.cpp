@@ -0,0 +1,234 @@
+#include <erosion/pipe_erosion.h>
+#include <parallel/thread_pool.h>
+#include <simd/simd.h>
+
+#include <algorithm>
+#include <utility>
+
+
+PipeErosion::PipeErosion(int steps)
+    : m_steps(steps) {
+}
+
+void PipeErosion::setSteps(int steps) {
+    m_steps = steps;
+}
+
+int PipeErosion::getSteps() const {
+    return m_steps;
+}
+
+void PipeErosion::resize(int width, int height) {
+    // One ghost cell all round so neighbour reads at the map edge need no checks
+    for (HeightField* field : { &m_terrain, &m_water, &m_sediment, &m_sedimentNext,
+                                &m_fluxUp, &m_fluxDown, &m_fluxLeft, &m_fluxRight,
+                                &m_slope }) {
+        field->resize(width, height, 1);
+    }
+}
+
+void PipeErosion::refreshBorders() {
+    // Ghost cells copy the edge, so no water ever flows off the map.
+    // The flux and sediment ghosts are never written and stay zero.
+    m_terrain.clampBorder();
+    m_water.clampBorder();
+}
+
+void PipeErosion::apply(HeightField& heightMap, GenerationControl* control) {
+    int width = heightMap.width();
+    int height = heightMap.height();
+    if (m_steps <= 0 || width < 2 || height < 2) {
+        return;
+    }
+
+    // Every call starts from dry, clean terrain
+    resize(width, height);
+    for (int x = 0; x < width; ++x) {
+        std::copy(heightMap.row(x), heightMap.row(x) + height, m_terrain.row(x));
+    }
+    m_water.fill(rainRate * timeStep);
+
+    const int bandRows = HeightField::kTileSize;
+    int bands = (width + bandRows - 1) / bandRows;
+    ThreadPool& pool = ThreadPool::global();
+    auto forEachBand = [&](void (PipeErosion::*pass)(int, int)) {
+        pool.parallelFor(bands, [&](int band) {
+            int x0 = band * bandRows;
+            (this->*pass)(x0, std::min(x0 + bandRows, width));
+        });
+    };
+
+    for (int step = 0; step < m_steps; ++step) {
+        if (control) {
+            control->checkpoint(static_cast<float>(step) / m_steps);
+        }
+        refreshBorders();
+        forEachBand(&PipeErosion::computeFlux);
+        forEachBand(&PipeErosion::transportSediment);
+        std::swap(m_sediment, m_sedimentNext);
+        forEachBand(&PipeErosion::updateWater);
+    }
+
+    // Whatever is still suspended settles where it is
+    for (int x = 0; x < width; ++x) {
+        const float* terrain = m_terrain.row(x);
+        const float* sediment = m_sediment.row(x);
+        float* out = heightMap.row(x);
+        for (int z = 0; z < height; ++z) {
+            out[z] = terrain[z] + sediment[z];
+        }
+    }
+}
+
+void PipeErosion::computeFlux(int x0, int x1) {
+    using namespace simd;
+
+    int height = m_terrain.height();
+    const float fluxGain = timeStep * pipeArea * gravity;
+
+    for (int x = x0; x < x1; ++x) {
+        const float* terrain = m_terrain.row(x);
+        const float* water = m_water.row(x);
+        const float* terrainUp = m_terrain.row(x - 1);
+        const float* waterUp = m_water.row(x - 1);
+        const float* terrainDown = m_terrain.row(x + 1);
+        const float* waterDown = m_water.row(x + 1);
+        float* fluxUp = m_fluxUp.row(x);
+        float* fluxDown = m_fluxDown.row(x);
+        float* fluxLeft = m_fluxLeft.row(x);
+        float* fluxRight = m_fluxRight.row(x);
+        float* slope = m_slope.row(x);
+
+        forEachLane(height, [&](int z, size_t n, auto partial) {
+            constexpr bool P = decltype(partial)::value;
+            auto at = [&](const float* row, int dz) { return loadLanes<P>(row + z + dz, n); };
+
+            const vfloat zero = set1(0.0f);
+            const vfloat gain = set1(fluxGain);
+            vfloat depth = at(water, 0);
+            vfloat surface = at(terrain, 0) + depth;
+
+            // Pipes only carry water out of a cell; inflow is the neighbour's outflow
+            vfloat up = max(zero, at(fluxUp, 0) + gain * (surface - (at(terrainUp, 0) + at(waterUp, 0))));
+            vfloat down = max(zero, at(fluxDown, 0) + gain * (surface - (at(terrainDown, 0) + at(waterDown, 0))));
+            vfloat left = max(zero, at(fluxLeft, 0) + gain * (surface - (at(terrain, -1) + at(water, -1))));
+            vfloat right = max(zero, at(fluxRight, 0) + gain * (surface - (at(terrain, 1) + at(water, 1))));
+
+            // Never send more water than the cell holds
+            vfloat outflow = (up + down + left + right) * set1(timeStep);
+            vfloat scale = select(outflow > depth, depth / outflow, set1(1.0f));
+
+            storeLanes<P>(fluxUp + z, up * scale, n);
+            storeLanes<P>(fluxDown + z, down * scale, n);
+            storeLanes<P>(fluxLeft + z, left * scale, n);
+            storeLanes<P>(fluxRight + z, right * scale, n);
+
+            // Sine of the terrain tilt, for the sediment capacity
+            vfloat gradX = (at(terrainDown, 0) - at(terrainUp, 0)) * set1(0.5f);
+            vfloat gradZ = (at(terrain, 1) - at(terrain, -1)) * set1(0.5f);
+            vfloat grad2 = gradX * gradX + gradZ * gradZ;
+            storeLanes<P>(slope + z, sqrt(grad2 / (set1(1.0f) + grad2)), n);
+        });
+    }
+}
+
+void PipeErosion::transportSediment(int x0, int x1) {
+    using namespace simd;
+
+    int height = m_terrain.height();
+
+    for (int x = x0; x < x1; ++x) {
+        const float* water = m_water.row(x);
+        const float* waterUp = m_water.row(x - 1);
+        const float* waterDown = m_water.row(x + 1);
+        const float* sediment = m_sediment.row(x);
+        const float* sedimentUp = m_sediment.row(x - 1);
+        const float* sedimentDown = m_sediment.row(x + 1);
+        const float* fluxUp = m_fluxUp.row(x);
+        const float* fluxDown = m_fluxDown.row(x);
+        const float* fluxLeft = m_fluxLeft.row(x);
+        const float* fluxRight = m_fluxRight.row(x);
+        const float* fromAbove = m_fluxDown.row(x - 1);
+        const float* fromBelow = m_fluxUp.row(x + 1);
+        float* target = m_sedimentNext.row(x);
+
+        forEachLane(height, [&](int z, size_t n, auto partial) {
+            constexpr bool P = decltype(partial)::value;
+            auto at = [&](const float* row, int dz) { return loadLanes<P>(row + z + dz, n); };
+
+            // Fraction of a cell's water (and so of its sediment) leaving through a pipe
+            const vfloat dt = set1(timeStep);
+            auto share = [&](vfloat flux, vfloat depth) {
+                return select(depth > set1(0.0f), flux * dt / depth, set1(0.0f));
+            };
+
+            vfloat outflow = at(fluxUp, 0) + at(fluxDown, 0) + at(fluxLeft, 0) + at(fluxRight, 0);
+            vfloat kept = at(sediment, 0) * (set1(1.0f) - share(outflow, at(water, 0)));
+            vfloat received = at(sedimentUp, 0) * share(at(fromAbove, 0), at(waterUp, 0))
+                            + at(sedimentDown, 0) * share(at(fromBelow, 0), at(waterDown, 0))
+                            + at(sediment, -1) * share(at(fluxRight, -1), at(water, -1))
+                            + at(sediment, 1) * share(at(fluxLeft, 1), at(water, 1));
+            storeLanes<P>(target + z, kept + received, n);
+        });
+    }
+}
+
+void PipeErosion::updateWater(int x0, int x1) {
+    using namespace simd;
+
+    int height = m_terrain.height();
+    const float decay = 1.0f - evaporationRate * timeStep;
+
+    for (int x = x0; x < x1; ++x) {
+        float* terrain = m_terrain.row(x);
+        float* water = m_water.row(x);
+        float* sediment = m_sediment.row(x);
+        const float* slope = m_slope.row(x);
+        const float* fluxUp = m_fluxUp.row(x);
+        const float* fluxDown = m_fluxDown.row(x);
+        const float* fluxLeft = m_fluxLeft.row(x);
+        const float* fluxRight = m_fluxRight.row(x);
+        const float* fromAbove = m_fluxDown.row(x - 1);
+        const float* fromBelow = m_fluxUp.row(x + 1);
+
+        forEachLane(height, [&](int z, size_t n, auto partial) {
+            constexpr bool P = decltype(partial)::value;
+            auto at = [&](const float* row, int dz) { return loadLanes<P>(row + z + dz, n); };
+
+            const vfloat zero = set1(0.0f);
+            const vfloat half = set1(0.5f);
+            vfloat up = at(fluxUp, 0);
+            vfloat down = at(fluxDown, 0);
+            vfloat left = at(fluxLeft, 0);
+            vfloat right = at(fluxRight, 0);
+            vfloat inAbove = at(fromAbove, 0);
+            vfloat inBelow = at(fromBelow, 0);
+            vfloat inLeft = at(fluxRight, -1);
+            vfloat inRight = at(fluxLeft, 1);
+
+            vfloat inflow = inAbove + inBelow + inLeft + inRight;
+            vfloat outflow = up + down + left + right;
+            vfloat depth = at(water, 0);
+            vfloat newDepth = max(zero, depth + set1(timeStep) * (inflow - outflow));
+
+            // Net flow through the cell over the mean depth gives the velocity
+            vfloat meanDepth = max(set1(1e-4f), (depth + newDepth) * half);
+            vfloat vx = ((inAbove - up) + (down - inBelow)) * half / meanDepth;
+            vfloat vz = ((inLeft - left) + (right - inRight)) * half / meanDepth;
+            vfloat speed = sqrt(vx * vx + vz * vz);
+
+            // Very shallow water carries little, however fast it moves
+            vfloat depthFactor = min(newDepth * set1(1.0f / maxErosionDepth), set1(1.0f));
+            vfloat capacity = set1(sedimentCapacity) * max(at(slope, 0), set1(minTilt)) * speed * depthFactor;
+            vfloat suspended = at(sediment, 0);
+            // Positive dissolves terrain into the water, negative deposits it
+            vfloat exchange = select(capacity > suspended,
+                                     set1(dissolveRate * timeStep) * (capacity - suspended),
+                                     set1(-depositRate * timeStep) * (suspended - capacity));
+
+            storeLanes<P>(terrain + z, at(terrain, 0) - exchange, n);
+            storeLanes<P>(sediment + z, suspended + exchange, n);
+            storeLanes<P>(water + z, newDepth * set1(decay) + set1(rainRate * timeStep), n);
+        });
+    }
+}
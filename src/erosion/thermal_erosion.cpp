@@ -0,0 +1,193 @@
+#include <erosion/thermal_erosion.h>
+#include <parallel/thread_pool.h>
+#include <simd/simd.h>
+
+#include <utility>
+#include <vector>
+
+
+ThermalErosion::ThermalErosion(int iterations, float talus, float rate, float maxTransfer)
+    : m_iterations(iterations)
+    , m_talus(talus)
+    , m_rate(rate)
+    , m_maxTransfer(maxTransfer) {
+}
+
+void ThermalErosion::setIterations(int iterations) {
+    m_iterations = iterations;
+}
+
+void ThermalErosion::setTalus(float talus) {
+    m_talus = talus;
+}
+
+void ThermalErosion::setRate(float rate) {
+    m_rate = rate;
+}
+
+void ThermalErosion::setMaxTransfer(float maxTransfer) {
+    m_maxTransfer = maxTransfer;
+}
+
+int ThermalErosion::getIterations() const {
+    return m_iterations;
+}
+
+float ThermalErosion::getTalus() const {
+    return m_talus;
+}
+
+void ThermalErosion::apply(HeightField& heightMap) {
+    int width = heightMap.width();
+    int height = heightMap.height();
+    if (width < 3 || height < 3 || m_iterations <= 0) {
+        return;
+    }
+
+    if (m_scratch.width() != width || m_scratch.height() != height || m_scratch.border() != heightMap.border()) {
+        m_scratch.resize(width, height, heightMap.border());
+    }
+
+    const int bandRows = HeightField::kTileSize;
+    int bands = (width + bandRows - 1) / bandRows;
+    ThreadPool& pool = ThreadPool::global();
+
+    HeightField* source = &heightMap;
+    HeightField* target = &m_scratch;
+    for (int iter = 0; iter < m_iterations; ++iter) {
+        pool.parallelFor(bands, [&](int band) {
+            int x0 = band * bandRows;
+            int x1 = std::min(x0 + bandRows, width);
+            erodeBand(source->view(), target->view(), x0, x1);
+        });
+        std::swap(source, target);
+    }
+
+    // Odd iteration count: the result is in the scratch grid
+    if (source != &heightMap) {
+        std::swap(heightMap, m_scratch);
+    }
+}
+
+namespace {
+// Outgoing transfer of cells [z, z + n) of the middle row. Directions are
+// coded (dx + 1) * 3 + (dz + 1), or -1 when the cell keeps its material;
+// ties go to the first neighbour in raster order.
+template <bool Partial>
+void transferLanes(const float* const rows[3], int z, size_t n,
+                   float talus, float rate, float maxTransfer,
+                   float* amount, float* direction) {
+    using namespace simd;
+
+    const vfloat center = loadLanes<Partial>(rows[1] + z, n);
+    vfloat maxDiff = set1(0.0f);
+    vfloat dir = set1(-1.0f);
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dz = -1; dz <= 1; dz++) {
+            if (dx == 0 && dz == 0) continue;
+
+            vfloat diff = center - loadLanes<Partial>(rows[dx + 1] + z + dz, n);
+            vmask steeper = diff > maxDiff;
+            maxDiff = select(steeper, diff, maxDiff);
+            dir = select(steeper, set1(static_cast<float>((dx + 1) * 3 + (dz + 1))), dir);
+        }
+    }
+
+    vmask erode = maxDiff > set1(talus);
+    vfloat moved = min((maxDiff - set1(talus)) * set1(rate), set1(maxTransfer));
+    storeLanes<Partial>(amount + z, select(erode, moved, set1(0.0f)), n);
+    storeLanes<Partial>(direction + z, select(erode, dir, set1(-1.0f)), n);
+}
+
+// New heights of cells [z, z + n): own height minus what left, plus what the
+// neighbours sent here, summed in the order the old serial scatter used
+template <bool Partial>
+void gatherLanes(const float* own, const float* const amount[3], const float* const direction[3],
+                 int z, size_t n, float* out) {
+    using namespace simd;
+
+    vfloat value = loadLanes<Partial>(own + z, n);
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dz = -1; dz <= 1; dz++) {
+            if (dx == 0 && dz == 0) {
+                value = value - loadLanes<Partial>(amount[1] + z, n);
+                continue;
+            }
+            // A neighbour at (dx, dz) sends here if it points back at (-dx, -dz)
+            vfloat towardsUs = set1(static_cast<float>((1 - dx) * 3 + (1 - dz)));
+            vmask sent = loadLanes<Partial>(direction[dx + 1] + z + dz, n) == towardsUs;
+            value = value + select(sent, loadLanes<Partial>(amount[dx + 1] + z + dz, n), set1(0.0f));
+        }
+    }
+    storeLanes<Partial>(out + z, value, n);
+}
+}
+
+void ThermalErosion::erodeBand(ConstHeightFieldView source, HeightFieldView target, int x0, int x1) const {
+    int width = source.width();
+    int height = source.height();
+    const int lanes = simd::kWidth;
+
+    // Rolling window of outgoing transfers for rows x-1..x+1, indexed by
+    // row % 3, plus an all-empty slot standing in for rows off the map.
+    // Each slot is padded by one cell either side so edge cells need no checks.
+    const int pitch = height + 2;
+    const int emptySlot = 3;
+    std::vector<float> amount(4 * pitch, 0.0f);
+    std::vector<float> direction(4 * pitch, -1.0f);
+
+    auto slot = [&](int r) {
+        return (r < 0 || r >= width) ? emptySlot : r % 3;
+    };
+
+    auto computeTransfer = [&](int r) {
+        float* a = amount.data() + slot(r) * pitch + 1;
+        float* d = direction.data() + slot(r) * pitch + 1;
+        if (r == 0 || r == width - 1) {
+            std::fill(a - 1, a - 1 + pitch, 0.0f);
+            std::fill(d - 1, d - 1 + pitch, -1.0f);
+            return;
+        }
+
+        // Outer columns never send
+        a[-1] = a[0] = a[height - 1] = a[height] = 0.0f;
+        d[-1] = d[0] = d[height - 1] = d[height] = -1.0f;
+
+        const float* rows[3] = { source.row(r - 1), source.row(r), source.row(r + 1) };
+        int z = 1;
+        for (; z + lanes <= height - 1; z += lanes) {
+            transferLanes<false>(rows, z, lanes, m_talus, m_rate, m_maxTransfer, a, d);
+        }
+        if (z < height - 1) {
+            transferLanes<true>(rows, z, height - 1 - z, m_talus, m_rate, m_maxTransfer, a, d);
+        }
+    };
+
+    if (x0 > 0) {
+        computeTransfer(x0 - 1);
+    }
+    computeTransfer(x0);
+
+    for (int x = x0; x < x1; ++x) {
+        if (x + 1 < width) {
+            computeTransfer(x + 1);
+        }
+
+        const float* amounts[3];
+        const float* directions[3];
+        for (int dx = -1; dx <= 1; dx++) {
+            amounts[dx + 1] = amount.data() + slot(x + dx) * pitch + 1;
+            directions[dx + 1] = direction.data() + slot(x + dx) * pitch + 1;
+        }
+
+        const float* own = source.row(x);
+        float* out = target.row(x);
+        int z = 0;
+        for (; z + lanes <= height; z += lanes) {
+            gatherLanes<false>(own, amounts, directions, z, lanes, out);
+        }
+        if (z < height) {
+            gatherLanes<true>(own, amounts, directions, z, height - z, out);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include <noise/cellular_noise.h>
+#include <simd/simd.h>
+
+
+CellularNoise::CellularNoise(std::uint32_t seed, float jitter)
+    : m_seed(seed)
+    , m_jitter(jitter) {
+}
+
+namespace {
+// Integer avalanche hash of a cell, evaluated per lane
+simd::vint hashCell(simd::vint x, simd::vint y, simd::vint seed) {
+    simd::vint h = x * simd::set1i(static_cast<std::int32_t>(0x8da6b343u))
+                 ^ y * simd::set1i(static_cast<std::int32_t>(0xd8163841u))
+                 ^ seed;
+    h = h ^ simd::shiftRight<16>(h);
+    h = h * simd::set1i(static_cast<std::int32_t>(0x7feb352du));
+    h = h ^ simd::shiftRight<15>(h);
+    h = h * simd::set1i(static_cast<std::int32_t>(0x846ca68bu));
+    h = h ^ simd::shiftRight<16>(h);
+    return h;
+}
+
+simd::vfloat cellularKernel(simd::vfloat px, simd::vfloat py, simd::vint seed, float jitter,
+                            CellularNoise::Distance distance) {
+    using namespace simd;
+
+    const vfloat cellX = floor(px);
+    const vfloat cellY = floor(py);
+    const vint ix = toInt(cellX);
+    const vint iy = toInt(cellY);
+    const vfloat fx = px - cellX;
+    const vfloat fy = py - cellY;
+
+    // Feature point at 0.5 + (u - 0.5) * jitter inside its cell, u in [0, 1)
+    const vfloat scale = set1(jitter / 65536.0f);
+    const vfloat bias = set1(0.5f - 0.5f * jitter);
+    const vint lowBits = set1i(0xffff);
+
+    vfloat f1 = set1(1e30f);
+    vfloat f2 = set1(1e30f);
+
+    for (int ox = -1; ox <= 1; ++ox) {
+        for (int oy = -1; oy <= 1; ++oy) {
+            const vint h = hashCell(ix + set1i(ox), iy + set1i(oy), seed);
+            const vfloat pointX = toFloat(h & lowBits) * scale + bias + set1(static_cast<float>(ox));
+            const vfloat pointY = toFloat(shiftRight<16>(h)) * scale + bias + set1(static_cast<float>(oy));
+
+            const vfloat dx = pointX - fx;
+            const vfloat dy = pointY - fy;
+            const vfloat d2 = dx * dx + dy * dy;
+
+            f2 = min(f2, max(f1, d2));
+            f1 = min(f1, d2);
+        }
+    }
+
+    switch (distance) {
+        case CellularNoise::Distance::F2:
+            return sqrt(f2);
+        case CellularNoise::Distance::EDGE:
+            return sqrt(f2) - sqrt(f1);
+        case CellularNoise::Distance::F1:
+        default:
+            return sqrt(f1);
+    }
+}
+}
+
+float CellularNoise::noise2D(float x, float y, Distance distance) const {
+    float out;
+    noise2D(&x, &y, &out, 1, distance);
+    return out;
+}
+
+void CellularNoise::noise2D(const float* xs, const float* ys, float* out, size_t count,
+                            Distance distance) const {
+    const simd::vint seed = simd::set1i(static_cast<std::int32_t>(m_seed));
+    const size_t width = simd::kWidth;
+
+    size_t i = 0;
+    for (; i + width <= count; i += width) {
+        simd::store(out + i, cellularKernel(simd::load(xs + i), simd::load(ys + i), seed, m_jitter, distance));
+    }
+    if (i < count) {
+        size_t rest = count - i;
+        simd::vfloat result = cellularKernel(simd::loadPartial(xs + i, rest), simd::loadPartial(ys + i, rest),
+                                             seed, m_jitter, distance);
+        simd::storePartial(out + i, result, rest);
+    }
+}
@@ -0,0 +1,123 @@
+#include <parallel/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The thread calling parallelFor counts as one of the workers
+    for (unsigned i = 1; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::getThreadCount() const {
+    return static_cast<unsigned>(m_workers.size()) + 1;
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_jobAvailable.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping && m_jobs.empty()) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1 || m_workers.empty()) {
+        for (int i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    // Shared with the helper jobs, which may only get scheduled after the
+    // caller has already drained every index
+    struct Batch {
+        std::atomic<int> next{0};
+        std::atomic<int> finished{0};
+        int count = 0;
+        const std::function<void(int)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->count = count;
+    batch->fn = &fn;
+
+    auto drain = [](Batch& b) {
+        int completed = 0;
+        for (int i = b.next.fetch_add(1); i < b.count; i = b.next.fetch_add(1)) {
+            (*b.fn)(i);
+            ++completed;
+        }
+        if (completed > 0 && b.finished.fetch_add(completed) + completed == b.count) {
+            std::lock_guard<std::mutex> lock(b.mutex);
+            b.done.notify_all();
+        }
+    };
+
+    int helpers = std::min<int>(static_cast<int>(m_workers.size()), count - 1);
+    for (int i = 0; i < helpers; ++i) {
+        enqueue([batch, drain]() { drain(*batch); });
+    }
+
+    drain(*batch);
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&]() { return batch->finished.load() == count; });
+}
+
+namespace {
+std::unique_ptr<ThreadPool>& globalPool() {
+    static std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+    return pool;
+}
+}
+
+ThreadPool& ThreadPool::global() {
+    return *globalPool();
+}
+
+void ThreadPool::setGlobalThreadCount(unsigned threadCount) {
+    auto& pool = globalPool();
+    if (pool->getThreadCount() != threadCount || threadCount == 0) {
+        pool.reset();
+        pool = std::make_unique<ThreadPool>(threadCount);
+    }
+}
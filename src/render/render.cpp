@@ -1,4 +1,5 @@
 #include <render/render.h>
+#include <cmath>
 
 
 Renderer::Renderer(Camera& camera, Shader& shader, Terrain& terrain, float aspectRatio)
@@ -13,17 +14,23 @@ void Renderer::render() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     m_shader.use();
-    setupMatrices();
+    glm::mat4 viewProjection = setupMatrices();
     m_shader.setFloat("yScale",m_terrain.getYScale());
     m_shader.setFloat("yShift",m_terrain.getYShift());
     m_shader.setFloat("heightMin", m_terrain.getheightMin() * m_terrain.getYScale() - m_terrain.getYShift());
-    m_shader.setFloat("actualMaxHeight", m_terrain.getheightMax() * m_terrain.getYScale() - m_terrain.getYShift());    
-    m_terrain.render();
+    m_shader.setFloat("heightMax", m_terrain.getheightMax() * m_terrain.getYScale() - m_terrain.getYShift());    
+    m_shader.setVec3("cameraPosition", m_camera.Position);
+
+    // Pixels covered by one world unit at distance 1, for the terrain's LOD
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = viewport[3] / (2.0f * std::tan(glm::radians(m_camera.Zoom) / 2.0f));
+    m_terrain.render(viewProjection, m_camera.Position, pixelsPerUnit);
 }
 
 
 
-void Renderer::setupMatrices() {
+glm::mat4 Renderer::setupMatrices() {
     glm::mat4 projection = glm::perspective(glm::radians(m_camera.Zoom), m_aspectRatio, m_near, m_far);
     m_shader.setMat4("projection", projection);
 
@@ -32,4 +39,7 @@ void Renderer::setupMatrices() {
 
     glm::mat4 model = glm::mat4(1.0f);
     m_shader.setMat4("model", model);
+
+    // For culling the terrain chunks
+    return projection * view * model;
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include <render/texture_array.h>
+
+#include <stb/stb_image.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'N', 'T', 'A'};
+constexpr std::uint32_t kVersion = 1;
+
+// 2x2 box filter; sizes are powers of two so there is never an odd edge
+std::vector<unsigned char> halve(const unsigned char* src, int size) {
+    int half = size / 2;
+    std::vector<unsigned char> dst(static_cast<std::size_t>(half) * half * 4);
+    for (int y = 0; y < half; ++y) {
+        const unsigned char* r0 = src + static_cast<std::size_t>(2 * y) * size * 4;
+        const unsigned char* r1 = r0 + static_cast<std::size_t>(size) * 4;
+        unsigned char* out = dst.data() + static_cast<std::size_t>(y) * half * 4;
+        for (int x = 0; x < half; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                int sum = r0[8 * x + c] + r0[8 * x + 4 + c] + r1[8 * x + c] + r1[8 * x + 4 + c];
+                out[4 * x + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+// Bilinear resample of an RGBA image to size x size. Sources more than twice
+// the target are box-halved first so the bilinear step never skips texels.
+std::vector<unsigned char> resample(const unsigned char* pixels, int width, int height, int size) {
+    std::vector<unsigned char> src(pixels, pixels + static_cast<std::size_t>(width) * height * 4);
+    while (width == height && width >= 2 * size && (width & 1) == 0) {
+        src = halve(src.data(), width);
+        width /= 2;
+        height /= 2;
+    }
+    if (width == size && height == size) {
+        return src;
+    }
+
+    std::vector<unsigned char> dst(static_cast<std::size_t>(size) * size * 4);
+    float sx = static_cast<float>(width) / size;
+    float sy = static_cast<float>(height) / size;
+    for (int y = 0; y < size; ++y) {
+        float fy = std::clamp((y + 0.5f) * sy - 0.5f, 0.0f, static_cast<float>(height - 1));
+        int y0 = static_cast<int>(fy);
+        int y1 = std::min(y0 + 1, height - 1);
+        float ty = fy - y0;
+        for (int x = 0; x < size; ++x) {
+            float fx = std::clamp((x + 0.5f) * sx - 0.5f, 0.0f, static_cast<float>(width - 1));
+            int x0 = static_cast<int>(fx);
+            int x1 = std::min(x0 + 1, width - 1);
+            float tx = fx - x0;
+            for (int c = 0; c < 4; ++c) {
+                auto at = [&](int px, int py) { return static_cast<float>(src[(static_cast<std::size_t>(py) * width + px) * 4 + c]); };
+                float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * tx;
+                float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * tx;
+                dst[(static_cast<std::size_t>(y) * size + x) * 4 + c] =
+                    static_cast<unsigned char>(std::lround(top + (bottom - top) * ty));
+            }
+        }
+    }
+    return dst;
+}
+
+std::uint16_t to565(const int* rgb) {
+    return static_cast<std::uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+void from565(std::uint16_t c, int* rgb) {
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Bounding-box BC1 encoder: endpoints are the per-channel min/max, inset by
+// 1/16 of the range, and every texel takes the nearest of the four colours
+void encodeBlock(const unsigned char block[16][4], unsigned char* out) {
+    int lo[3] = {255, 255, 255};
+    int hi[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            lo[c] = std::min<int>(lo[c], block[i][c]);
+            hi[c] = std::max<int>(hi[c], block[i][c]);
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        int inset = (hi[c] - lo[c]) >> 4;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    std::uint16_t c0 = to565(hi);
+    std::uint16_t c1 = to565(lo);
+    std::uint32_t indices = 0;
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+    if (c0 != c1) {
+        // c0 > c1 selects the four-colour mode
+        int palette[4][3];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            int bestDistance = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<std::uint32_t>(best) << (2 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(c0 & 0xff);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1 & 0xff);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+    }
+}
+
+std::vector<unsigned char> encodeBC1(const unsigned char* rgba, int size) {
+    int blocks = (size + 3) / 4;
+    std::vector<unsigned char> out(static_cast<std::size_t>(blocks) * blocks * 8);
+    unsigned char block[16][4];
+    for (int by = 0; by < blocks; ++by) {
+        for (int bx = 0; bx < blocks; ++bx) {
+            // Mips below 4x4 repeat their edge texels to fill the block
+            for (int i = 0; i < 16; ++i) {
+                int x = std::min(bx * 4 + (i & 3), size - 1);
+                int y = std::min(by * 4 + (i >> 2), size - 1);
+                std::memcpy(block[i], rgba + (static_cast<std::size_t>(y) * size + x) * 4, 4);
+            }
+            encodeBlock(block, out.data() + (static_cast<std::size_t>(by) * blocks + bx) * 8);
+        }
+    }
+    return out;
+}
+
+void writeU32(std::ofstream& file, std::uint32_t value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    file.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+std::uint64_t readUint(std::ifstream& file, int count) {
+    unsigned char bytes[8] = {};
+    file.read(reinterpret_cast<char*>(bytes), count);
+    std::uint64_t value = 0;
+    for (int i = 0; i < count; ++i) value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+int TextureArrayData::levelSize(int level) const {
+    return std::max(1, size >> level);
+}
+
+std::size_t TextureArrayData::layerBytes(int level) const {
+    std::size_t s = static_cast<std::size_t>(levelSize(level));
+    if (format == Format::BC1) {
+        return ((s + 3) / 4) * ((s + 3) / 4) * 8;
+    }
+    return s * s * 4;
+}
+
+TextureArrayData buildTextureArray(const std::vector<std::string>& paths, int size) {
+    if (size <= 0 || (size & (size - 1)) != 0) {
+        throw std::runtime_error("Texture array size must be a power of two");
+    }
+
+    TextureArrayData data;
+    data.size = size;
+    data.layers = static_cast<int>(paths.size());
+    int levelCount = 1;
+    while ((size >> (levelCount - 1)) > 1) ++levelCount;
+    data.levels.resize(levelCount);
+
+    for (const std::string& path : paths) {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!pixels) {
+            throw std::runtime_error("Failed to load texture: " + path);
+        }
+        std::vector<unsigned char> level = resample(pixels, width, height, size);
+        stbi_image_free(pixels);
+
+        for (int i = 0; i < levelCount; ++i) {
+            if (i > 0) {
+                level = halve(level.data(), data.levelSize(i - 1));
+            }
+            data.levels[i].insert(data.levels[i].end(), level.begin(), level.end());
+        }
+    }
+    return data;
+}
+
+void compressBC1(TextureArrayData& data) {
+    if (data.format != TextureArrayData::Format::RGBA8) {
+        throw std::runtime_error("Only RGBA8 texture arrays can be compressed");
+    }
+    for (int i = 0; i < static_cast<int>(data.levels.size()); ++i) {
+        int s = data.levelSize(i);
+        std::size_t layerBytes = static_cast<std::size_t>(s) * s * 4;
+        std::vector<unsigned char> compressed;
+        for (int layer = 0; layer < data.layers; ++layer) {
+            std::vector<unsigned char> blocks = encodeBC1(data.levels[i].data() + layer * layerBytes, s);
+            compressed.insert(compressed.end(), blocks.begin(), blocks.end());
+        }
+        data.levels[i] = std::move(compressed);
+    }
+    data.format = TextureArrayData::Format::BC1;
+}
+
+void writeTextureArray(const std::string& path, const TextureArrayData& data) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+    file.write(kMagic, 4);
+    writeU32(file, kVersion);
+    writeU32(file, static_cast<std::uint32_t>(data.format));
+    writeU32(file, static_cast<std::uint32_t>(data.size));
+    writeU32(file, static_cast<std::uint32_t>(data.layers));
+    writeU32(file, static_cast<std::uint32_t>(data.levels.size()));
+    for (const auto& level : data.levels) {
+        std::uint64_t bytes = level.size();
+        writeU32(file, static_cast<std::uint32_t>(bytes));
+        writeU32(file, static_cast<std::uint32_t>(bytes >> 32));
+        file.write(reinterpret_cast<const char*>(level.data()), level.size());
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+bool readTextureArray(const std::string& path, TextureArrayData& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    char magic[4] = {};
+    file.read(magic, 4);
+    if (!file || std::memcmp(magic, kMagic, 4) != 0 || readUint(file, 4) != kVersion) {
+        throw std::runtime_error(path + " is not a cooked texture array");
+    }
+    std::uint32_t format = static_cast<std::uint32_t>(readUint(file, 4));
+    if (format > static_cast<std::uint32_t>(TextureArrayData::Format::BC1)) {
+        throw std::runtime_error(path + " uses an unknown texture format");
+    }
+
+    TextureArrayData result;
+    result.format = static_cast<TextureArrayData::Format>(format);
+    result.size = static_cast<int>(readUint(file, 4));
+    result.layers = static_cast<int>(readUint(file, 4));
+    std::uint32_t levelCount = static_cast<std::uint32_t>(readUint(file, 4));
+    if (!file || result.size <= 0 || result.layers <= 0 || levelCount == 0 || levelCount > 32) {
+        throw std::runtime_error(path + " has a corrupt header");
+    }
+
+    result.levels.resize(levelCount);
+    for (std::uint32_t i = 0; i < levelCount; ++i) {
+        std::uint64_t bytes = readUint(file, 8);
+        if (bytes != result.layerBytes(i) * result.layers) {
+            throw std::runtime_error(path + " has a corrupt mip level");
+        }
+        result.levels[i].resize(bytes);
+        file.read(reinterpret_cast<char*>(result.levels[i].data()), bytes);
+    }
+    if (!file) {
+        throw std::runtime_error(path + " is truncated");
+    }
+
+    data = std::move(result);
+    return true;
+}
@@ -0,0 +1,133 @@
+#include <render/texture_cache.h>
+#include <render/texture_array.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// EXT_texture_compression_s3tc; not part of the core profile glad was built for
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+namespace {
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 1x1 mid grey in every layer
+TextureArrayData placeholderArray(int layers) {
+    TextureArrayData data;
+    data.format = TextureArrayData::Format::RGBA8;
+    data.size = 1;
+    data.layers = std::max(layers, 1);
+    data.levels.emplace_back(static_cast<std::size_t>(data.layers) * 4, static_cast<unsigned char>(128));
+    for (int layer = 0; layer < data.layers; ++layer) {
+        data.levels[0][layer * 4 + 3] = 255;
+    }
+    return data;
+}
+
+} // namespace
+
+
+TextureCache::~TextureCache() {
+    clear();
+}
+
+GLuint TextureCache::getArray(const std::string& cookedPath, const std::vector<std::string>& sourcePaths,
+                              int layerSize) {
+    auto it = m_textures.find(cookedPath);
+    if (it != m_textures.end()) {
+        return it->second;
+    }
+    GLuint texture = loadArray(cookedPath, sourcePaths, layerSize);
+    m_textures.emplace(cookedPath, texture);
+    return texture;
+}
+
+bool TextureCache::contains(const std::string& path) const {
+    return m_textures.count(path) != 0;
+}
+
+std::size_t TextureCache::size() const {
+    return m_textures.size();
+}
+
+void TextureCache::clear() {
+    for (auto& entry : m_textures) {
+        glDeleteTextures(1, &entry.second);
+    }
+    m_textures.clear();
+}
+
+GLuint TextureCache::loadArray(const std::string& cookedPath, const std::vector<std::string>& sourcePaths,
+                               int layerSize) const {
+    TextureArrayData data;
+    bool cooked = false;
+    try {
+        cooked = readTextureArray(cookedPath, data);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    // The shader picks materials by layer, so a stale file with a different
+    // material list would sample the wrong (or a clamped) layer
+    if (cooked && data.layers != static_cast<int>(sourcePaths.size())) {
+        std::cerr << cookedPath << " has " << data.layers << " layers, expected " << sourcePaths.size()
+                  << ", rebuilding" << std::endl;
+        cooked = false;
+    }
+    if (cooked && data.format == TextureArrayData::Format::BC1 &&
+        !hasExtension("GL_EXT_texture_compression_s3tc")) {
+        std::cerr << "no BC1 support, rebuilding " << cookedPath << std::endl;
+        cooked = false;
+    }
+    if (!cooked) {
+        std::cerr << "no usable cooked textures at " << cookedPath << ", decoding sources" << std::endl;
+        try {
+            data = buildTextureArray(sourcePaths, layerSize);
+        } catch (const std::runtime_error& e) {
+            // A missing material is not fatal: draw with a flat grey instead
+            std::cerr << "no texture: " << e.what() << std::endl;
+            data = placeholderArray(static_cast<int>(sourcePaths.size()));
+        }
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(data.levels.size()) - 1);
+
+    // Every mip is already in the file, so there is no glGenerateMipmap
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < static_cast<int>(data.levels.size()); ++level) {
+        GLsizei s = data.levelSize(level);
+        const auto& bytes = data.levels[level];
+        if (data.format == TextureArrayData::Format::BC1) {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                   s, s, data.layers, 0, static_cast<GLsizei>(bytes.size()), bytes.data());
+        } else {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, s, s, data.layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return texture;
+}
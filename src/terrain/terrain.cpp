@@ -1,56 +1,118 @@
 #include <terrain/terrain.h>
+#include <parallel/thread_pool.h>
+#include <simd/simd.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <tuple>
 
 
 // PerlinNoiseGenerator Implementation
-PerlinNoiseGenerator::PerlinNoiseGenerator(float frequency, int octaves, float persistence)
+PerlinNoiseGenerator::PerlinNoiseGenerator(float frequency, int octaves, float persistence, unsigned int seed)
     : m_frequency(frequency)
     , m_octaves(octaves)
     , m_persistence(persistence)
-    , m_seed(12345)
-    , perlin(siv::PerlinNoise(m_seed)) {
+    , m_seed(seed)
+    , perlin(siv::PerlinNoiseF(m_seed))
+    , cellular(m_seed)
+    , m_erosion(3, 0.05f) { // 3 iterations, talus angle in heightmap units
 }
 
-void PerlinNoiseGenerator::generateHeightMap(std::vector<std::vector<float>>& heightMap) {
-    int width = heightMap.size();
-    int height = heightMap[0].size();
-    
-    // Create domain warping noise for more natural terrain features
-    std::vector<std::vector<float>> warpX(width, std::vector<float>(height, 0.0f));
-    std::vector<std::vector<float>> warpZ(width, std::vector<float>(height, 0.0f));
-    
-    // Generate domain warping values
-    const float warpStrength = 10.0f;
-    for(int x = 0; x < width; ++x) {
-        for(int z = 0; z < height; ++z) {
-            float wx = perlin.noise2D(x * 0.01f, z * 0.01f);
-            float wz = perlin.noise2D(x * 0.01f + 100.0f, z * 0.01f + 100.0f);
-            warpX[x][z] = wx * warpStrength;
-            warpZ[x][z] = wz * warpStrength;
+void PerlinNoiseGenerator::generateHeightMap(HeightField& heightMap) {
+    // Domain warp, fBm/ridge/Worley and plateau shaping run fused per tile row,
+    // so no full-size intermediate grids are allocated. Every sample is computed
+    // independently of the tile it lands in, so the result is bit-identical for
+    // any thread count.
+    ThreadPool& pool = ThreadPool::global();
+    const int tiles = heightMap.tileCount();
+    std::atomic<int> done{0};
+    pool.parallelFor(tiles, [&](int tile) {
+        if (cancelled()) {
+            return;
         }
-    }
+        generateTile(heightMap, heightMap.tile(tile));
+        report(0.9f * static_cast<float>(++done) / tiles);
+    });
+    checkpoint(0.9f);
     
+    // Apply thermal erosion simulation (simplified)
+    m_erosion.apply(heightMap);
+    checkpoint(1.0f);
+}
+
+void PerlinNoiseGenerator::generateTile(HeightField& heightMap, const TileRange& tile) {
+    int span = tile.z1 - tile.z0;
+
     // Ridged multifractal parameters
     const float ridgeOffset = 1.0f;
     const float ridginess = 0.5f; // 0 = normal perlin, 1 = full ridge
+
+    // Per-row sample buffers for the batched noise kernel
+    std::vector<float> sampleX(span), sampleZ(span);
+    std::vector<float> sampleX2(span), sampleZ2(span);
+
+    // Domain warping for the current row
+    std::vector<float> rowWarpX(span), rowWarpZ(span);
+    const float warpStrength = 10.0f;
+
+    // Worley F1 distance per sample
+    std::vector<float> cellDistance(span);
+
+    std::vector<float> octaveNoise(span);
+    std::vector<float> noiseValue(span);
+    std::vector<float> turbulence(span);
     
-    // Apply fractal noise with domain warping
-    for(int x = 0; x < width; ++x) {
-        for(int z = 0; z < height; ++z) {
-            float amplitude = 1.0f;
-            float frequency = m_frequency;
-            float noiseValue = 0.0f;
-            float totalAmplitude = 0.0f;
-            
-            // Variable to accumulate turbulence for domain warping
-            float turbulence = 0.0f;
+    // Apply fractal noise with domain warping, one row and one octave at a time
+    for(int x = tile.x0; x < tile.x1; ++x) {
+        // Generate domain warping values for more natural terrain features
+        for(int k = 0; k < span; ++k) {
+            int z = tile.z0 + k;
+            sampleX[k] = x * 0.01f;
+            sampleZ[k] = z * 0.01f;
+            sampleX2[k] = x * 0.01f + 100.0f;
+            sampleZ2[k] = z * 0.01f + 100.0f;
+        }
+        perlin.noise2D(sampleX.data(), sampleZ.data(), rowWarpX.data(), span);
+        perlin.noise2D(sampleX2.data(), sampleZ2.data(), rowWarpZ.data(), span);
+        for(int k = 0; k < span; ++k) {
+            rowWarpX[k] *= warpStrength;
+            rowWarpZ[k] *= warpStrength;
+        }
 
-            for(int i = 0; i < m_octaves; ++i) {
-                // Apply domain warping for more natural terrain flow
-                float wx = x + warpX[x][z] * (i + 1) * 0.1f;
-                float wz = z + warpZ[x][z] * (i + 1) * 0.1f;
-                
-                // Calculate basic noise
-                float n = perlin.noise2D(wx * frequency, wz * frequency);
+        float amplitude = 1.0f;
+        float frequency = m_frequency;
+        float totalAmplitude = 0.0f;
+
+        std::fill(noiseValue.begin(), noiseValue.end(), 0.0f);
+        
+        // Variable to accumulate turbulence for domain warping
+        std::fill(turbulence.begin(), turbulence.end(), 0.0f);
+
+        for(int i = 0; i < m_octaves; ++i) {
+            // Apply domain warping for more natural terrain flow
+            for(int k = 0; k < span; ++k) {
+                int z = tile.z0 + k;
+                float wx = x + rowWarpX[k] * (i + 1) * 0.1f;
+                float wz = z + rowWarpZ[k] * (i + 1) * 0.1f;
+                sampleX[k] = wx * frequency;
+                sampleZ[k] = wz * frequency;
+            }
+
+            // Calculate basic noise
+            perlin.noise2D(sampleX.data(), sampleZ.data(), octaveNoise.data(), span);
+
+            // Worley noise for the lower frequencies to create erosion-like features
+            bool worley = i >= m_octaves / 2;
+            float worleyScale = 0.5f;
+            if (worley) {
+                cellular.noise2D(sampleX.data(), sampleZ.data(), cellDistance.data(), span);
+            }
+
+            for(int k = 0; k < span; ++k) {
+                float n = octaveNoise[k];
                 
                 // Apply ridged multifractal for mountains
                 if (i < m_octaves / 2) {
@@ -58,126 +120,78 @@ void PerlinNoiseGenerator::generateHeightMap(std::vector<std::vector<float>>& he
                     n = std::pow(n, 2.0f); // Sharpen ridges
                 }
                 
-                // Worley noise for the lower frequencies to create erosion-like features
-                if (i >= m_octaves / 2) {
-                    float worleyScale = 0.5f;
-                    float cellSize = 1.0f / (frequency * 2.0f);
-                    float worleyX = std::floor(wx * frequency) * cellSize;
-                    float worleyZ = std::floor(wz * frequency) * cellSize;
-                    float minDist = 1.0f;
-                    
-                    // Simple Worley noise calculation
-                    for (int ox = -1; ox <= 1; ox++) {
-                        for (int oz = -1; oz <= 1; oz++) {
-                            float cellX = worleyX + ox * cellSize;
-                            float cellZ = worleyZ + oz * cellSize;
-                            
-                            // Get random point in cell
-                            float randomX = cellX + cellSize * perlin.noise2D(cellX * 1000, cellZ * 1000);
-                            float randomZ = cellZ + cellSize * perlin.noise2D(cellX * 1000 + 50, cellZ * 1000 + 50);
-                            
-                            float dx = wx * frequency - randomX;
-                            float dz = wz * frequency - randomZ;
-                            float dist = std::sqrt(dx * dx + dz * dz);
-                            
-                            minDist = std::min(minDist, dist);
-                        }
-                    }
-                    
+                if (worley) {
+                    float minDist = std::min(cellDistance[k], 1.0f);
+
                     // Blend Perlin with Worley
                     n = n * (1.0f - worleyScale) + minDist * worleyScale;
                 }
                 
                 // Apply turbulence from previous octaves for more realistic variation
                 if (i > 0) {
-                    n += turbulence * 0.1f * i;
+                    n += turbulence[k] * 0.1f * i;
                 }
                 
                 // Accumulate noise with amplitude
-                noiseValue += n * amplitude;
-                totalAmplitude += amplitude;
+                noiseValue[k] += n * amplitude;
                 
                 // Update turbulence
-                turbulence = noiseValue;
-                
-                // Update amplitude and frequency for next octave
-                amplitude *= m_persistence;
-                frequency *= 2.0f;
+                turbulence[k] = noiseValue[k];
             }
+            totalAmplitude += amplitude;
             
+            // Update amplitude and frequency for next octave
+            amplitude *= m_persistence;
+            frequency *= 2.0f;
+        }
+
+        float* row = heightMap.row(x) + tile.z0;
+        for(int k = 0; k < span; ++k) {
             // Normalize and store
-            heightMap[x][z] = noiseValue / totalAmplitude;
+            row[k] = noiseValue[k] / totalAmplitude;
             
             // Apply additional terrain shaping
             float plateauAmount = 0.3f; // 0 = no plateaus, 1 = full plateaus
-            if (heightMap[x][z] > 0.7f) {
+            if (row[k] > 0.7f) {
                 // Create plateaus on high areas
-                float h = heightMap[x][z];
+                float h = row[k];
                 float t = (h - 0.7f) / 0.3f; // Normalize to 0-1 for plateau range
-                heightMap[x][z] = h * (1.0f - plateauAmount * t) + 0.8f * plateauAmount * t;
+                row[k] = h * (1.0f - plateauAmount * t) + 0.8f * plateauAmount * t;
             }
-            else if (heightMap[x][z] < -0.3f) {
+            else if (row[k] < -0.3f) {
                 // Flatten lowlands slightly
-                float h = heightMap[x][z];
+                float h = row[k];
                 float t = (-h - 0.3f) / 0.7f; // Normalize to 0-1 for lowland range
-                heightMap[x][z] = h * (1.0f - plateauAmount * t) - 0.4f * plateauAmount * t;
-            }
-        }
-    }
-    
-    // Apply thermal erosion simulation (simplified)
-    const int erosionIterations = 3;
-    const float talusAngle = 0.05f; // Talus angle in heightmap units
-    
-    for (int iter = 0; iter < erosionIterations; iter++) {
-        std::vector<std::vector<float>> heightMapCopy = heightMap;
-        
-        for(int x = 1; x < width - 1; ++x) {
-            for(int z = 1; z < height - 1; ++z) {
-                // Check all 8 neighbors
-                float maxDiff = 0.0f;
-                int maxX = x, maxZ = z;
-                
-                for (int dx = -1; dx <= 1; dx++) {
-                    for (int dz = -1; dz <= 1; dz++) {
-                        if (dx == 0 && dz == 0) continue;
-                        
-                        float diff = heightMapCopy[x][z] - heightMapCopy[x+dx][z+dz];
-                        if (diff > maxDiff) {
-                            maxDiff = diff;
-                            maxX = x + dx;
-                            maxZ = z + dz;
-                        }
-                    }
-                }
-                
-                // If slope is too steep, erode
-                if (maxDiff > talusAngle) {
-                    float transfer = (maxDiff - talusAngle) * 0.5f;
-                    heightMap[x][z] -= transfer;
-                    heightMap[maxX][maxZ] += transfer;
-                }
+                row[k] = h * (1.0f - plateauAmount * t) - 0.4f * plateauAmount * t;
             }
         }
     }
 }
 
-
 // FaultFormationGenerator Implementation
 FaultFormationGenerator::NoiseGenerator::NoiseGenerator(int seed) 
-    : m_seed(seed) {
+    : m_seed(seed)
+    , m_perlin(static_cast<siv::PerlinNoiseF::seed_type>(seed)) {
 }
 
 void FaultFormationGenerator::NoiseGenerator::setSeed(int seed) { 
     m_seed = seed; 
+    m_perlin.reseed(static_cast<siv::PerlinNoiseF::seed_type>(seed));
+}
+
+int FaultFormationGenerator::NoiseGenerator::getSeed() const {
+    return m_seed;
+}
+
+float FaultFormationGenerator::NoiseGenerator::getNoise(float x, float y) const {
+    return m_perlin.noise2D(x, y);
 }
 
-float FaultFormationGenerator::NoiseGenerator::getNoise(float x, float y) {
-    static siv::PerlinNoise perlin(m_seed);
-    return perlin.noise2D(x, y);
+void FaultFormationGenerator::NoiseGenerator::getNoise(const float* xs, const float* ys, float* out, size_t count) const {
+    m_perlin.noise2D(xs, ys, out, count);
 }
 
-float FaultFormationGenerator::NoiseGenerator::getOctaveNoise(float x, float y, int octaves, float persistence) {
+float FaultFormationGenerator::NoiseGenerator::getOctaveNoise(float x, float y, int octaves, float persistence) const {
     float total = 0.0f;
     float frequency = 1.0f;
     float amplitude = 1.0f;
@@ -193,19 +207,54 @@ float FaultFormationGenerator::NoiseGenerator::getOctaveNoise(float x, float y,
     return total / maxValue;
 }
 
+void FaultFormationGenerator::NoiseGenerator::getOctaveNoise(const float* xs, const float* ys, float* out, size_t count,
+                                                             int octaves, float persistence) const {
+    std::vector<float> sampleX(count), sampleY(count), sample(count);
+    std::fill(out, out + count, 0.0f);
+
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    float maxValue = 0.0f;
+
+    for(int i = 0; i < octaves; i++) {
+        for(size_t k = 0; k < count; ++k) {
+            sampleX[k] = xs[k] * frequency;
+            sampleY[k] = ys[k] * frequency;
+        }
+        getNoise(sampleX.data(), sampleY.data(), sample.data(), count);
+        for(size_t k = 0; k < count; ++k) {
+            out[k] += sample[k] * amplitude;
+        }
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= 2.0f;
+    }
+
+    for(size_t k = 0; k < count; ++k) {
+        out[k] /= maxValue;
+    }
+}
+
 // FaultFormationGenerator Implementation
-FaultFormationGenerator::FaultFormationGenerator(int iterations, float minDelta, float maxDelta)
+FaultFormationGenerator::FaultFormationGenerator(int iterations, float minDelta, float maxDelta, unsigned int seed)
     : m_iterations(iterations)
     , m_minDelta(minDelta)
     , m_maxDelta(maxDelta)
     , m_terrainType(GENERIC)
-    , m_noise(12345) {
+    , m_rng(seed, RngStream::FAULT_LINES)
+    , m_noise(static_cast<int>(seed))
+    , m_detailNoise(static_cast<int>(seed) + 1)
+    , m_erosion(5, 0.0f, 0.1f, 0.05f) { // moves min(drop * 0.1, 0.05) per iteration
 }
 
 void FaultFormationGenerator::setTerrainType(FaultFormationGenerator::TerrainType type) {
     m_terrainType = type;
 }
 
+void FaultFormationGenerator::setPerIterationNoise(bool enabled) {
+    m_perIterationNoise = enabled;
+}
+
 float FaultFormationGenerator::calculateDisplacement(float iteration, float totalIterations) {
     // Exponentially decrease displacement as iterations progress
     float progress = iteration / totalIterations;
@@ -216,9 +265,9 @@ float FaultFormationGenerator::calculateDisplacement(float iteration, float tota
 }
 
 std::pair<glm::vec2, glm::vec2> FaultFormationGenerator::generateFaultPoints(int width, int height, float iteration) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    // Each fault draws from its own slots, so any fault can be made on its own
+    unsigned int fault = static_cast<unsigned int>(iteration);
+    auto dis = [&](unsigned int draw) { return m_rng.uniform(fault, draw); };
     
     // Calculate center point and radius
     float centerX = width * 0.5f;
@@ -231,179 +280,282 @@ std::pair<glm::vec2, glm::vec2> FaultFormationGenerator::generateFaultPoints(int
     
     // Generate angle for first point with potential bias
     float angle1;
-    if (dis(gen) < directionalBias) {
+    if (dis(0) < directionalBias) {
         // Apply bias toward preferred direction
-        angle1 = preferredAngle + (dis(gen) - 0.5f) * M_PI * 0.3f;
+        angle1 = preferredAngle + (dis(1) - 0.5f) * M_PI * 0.3f;
     } else {
-        angle1 = dis(gen) * 2.0f * M_PI;
+        angle1 = dis(1) * 2.0f * M_PI;
     }
     
     float x1 = centerX + radius * std::cos(angle1);
     float y1 = centerY + radius * std::sin(angle1);
     
     // Generate angle for second point (opposite side with variation)
-    float angle2 = angle1 + M_PI + (dis(gen) - 0.5f) * M_PI * 0.5f;
+    float angle2 = angle1 + M_PI + (dis(2) - 0.5f) * M_PI * 0.5f;
     float x2 = centerX + radius * std::cos(angle2);
     float y2 = centerY + radius * std::sin(angle2);
     
     return std::make_pair(glm::vec2(x1, y1), glm::vec2(x2, y2));
 }
 
-void FaultFormationGenerator::createFault(std::vector<std::vector<float>>& heightMap, float iteration) {
-    int width = heightMap.size();
-    int height = heightMap[0].size();
-    
+FaultFormationGenerator::FaultLine FaultFormationGenerator::makeFault(int width, int height, float iteration) {
     // Generate fault line points
     auto [p1, p2] = generateFaultPoints(width, height, iteration);
     
-    // Calculate line parameters (ax + by + c = 0)
+    // Calculate line parameters (ax + by + c = 0), scaled so the left hand
+    // side is the signed distance from the line
     float a = p2.y - p1.y;
     float b = -(p2.x - p1.x);
     float c = p2.x * p1.y - p1.x * p2.y;
     float normal = std::sqrt(a * a + b * b);
-    
+
+    FaultLine fault;
+    fault.a = a / normal;
+    fault.b = b / normal;
+    fault.c = c / normal;
     // Calculate displacement based on current iteration
-    float displacement = calculateDisplacement(iteration, m_iterations);
-    
-    // Apply displacement with smooth falloff
+    fault.displacement = calculateDisplacement(iteration, m_iterations);
+    return fault;
+}
+
+void FaultFormationGenerator::sampleNoiseFields(const NoiseGenerator& noise, int x, int z0, int span,
+                                                float falloffDistance, float* perturb, float* falloff) const {
+    std::vector<float> sampleX(span), sampleY(span), sampleX2(span), sampleY2(span);
+    for(int k = 0; k < span; ++k) {
+        int y = z0 + k;
+        sampleX[k] = static_cast<float>(x) * 0.01f;
+        sampleY[k] = static_cast<float>(y) * 0.01f;
+        sampleX2[k] = static_cast<float>(x) * 0.005f;
+        sampleY2[k] = static_cast<float>(y) * 0.005f;
+    }
+    noise.getNoise(sampleX.data(), sampleY.data(), perturb, span);
+    noise.getNoise(sampleX2.data(), sampleY2.data(), falloff, span);
+
+    for(int k = 0; k < span; ++k) {
+        // Apply noise to perturb the distance calculation
+        perturb[k] *= 10.0f;
+        // Calculate falloff factor with variable falloff distance
+        falloff[k] = falloffDistance * (1.0f + 0.3f * falloff[k]);
+    }
+}
+
+void FaultFormationGenerator::buildNoiseFields(int width, int height) {
+    if (m_perIterationNoise) {
+        m_faultNoise.clear();
+        for(int i = 0; i < m_iterations; ++i) {
+            m_faultNoise.emplace_back(m_noise.getSeed() + i * 1000);
+        }
+        return;
+    }
+
+    bool cached = m_perturbation.width() == width && m_perturbation.height() == height
+               && m_fieldSeed == m_noise.getSeed();
+    if (cached) {
+        return;
+    }
+
+    m_perturbation.resize(width, height);
+    m_falloff.resize(width, height);
+    m_fieldSeed = m_noise.getSeed();
+
     const float falloffDistance = std::min(width, height) * 0.1f;
-    
-    // Use existing noise generator for fault perturbation
-    m_noise.setSeed(static_cast<int>(iteration * 1000));
-    
-    #pragma omp parallel for collapse(2)
-    for(int x = 0; x < width; ++x) {
-        for(int y = 0; y < height; ++y) {
-            // Apply noise to perturb the distance calculation
-            float noiseValue = m_noise.getNoise(static_cast<float>(x) * 0.01f, 
-                                               static_cast<float>(y) * 0.01f) * 10.0f;
-            
-            // Perturbed distance calculation
-            float distance = (a * x + b * y + c) / normal + noiseValue;
-            
-            // Calculate falloff factor with variable falloff distance
-            float localFalloffDistance = falloffDistance * (1.0f + 0.3f * 
-                m_noise.getNoise(static_cast<float>(x) * 0.005f, static_cast<float>(y) * 0.005f));
-            float falloff = 1.0f;
-            
-            if(std::abs(distance) < localFalloffDistance) {
-                falloff = std::abs(distance) / localFalloffDistance;
-                falloff = 0.5f + 0.5f * std::cos(falloff * M_PI);
+    ThreadPool::global().parallelFor(width, [&](int x) {
+        sampleNoiseFields(m_noise, x, 0, height, falloffDistance, m_perturbation.row(x), m_falloff.row(x));
+    });
+}
+
+namespace {
+// 0.5 + 0.5 * cos(pi * t) for t in [0, 1], written as 0.5 - 0.5 * sin(pi * (t - 0.5))
+// with the sine's Taylor series to x^11 (error below 1e-7 on [-pi/2, pi/2])
+simd::vfloat cosineFalloff(simd::vfloat t) {
+    using namespace simd;
+    vfloat x = (t - set1(0.5f)) * set1(static_cast<float>(M_PI));
+    vfloat x2 = x * x;
+    vfloat p = set1(-1.0f / 39916800.0f);
+    p = p * x2 + set1(1.0f / 362880.0f);
+    p = p * x2 + set1(-1.0f / 5040.0f);
+    p = p * x2 + set1(1.0f / 120.0f);
+    p = p * x2 + set1(-1.0f / 6.0f);
+    p = p * x2 + set1(1.0f);
+    return set1(0.5f) - set1(0.5f) * (p * x);
+}
+}
+
+void FaultFormationGenerator::applyFaults(HeightField& heightMap, const TileRange& tile,
+                                          const std::vector<FaultLine>& faults) {
+    int rows = tile.x1 - tile.x0;
+    int span = tile.z1 - tile.z0;
+
+    // Apply displacement with smooth falloff
+    const float falloffDistance = std::min(heightMap.width(), heightMap.height()) * 0.1f;
+
+    // Bounds on the perturbation and falloff width over the tile. Perlin noise
+    // never exceeds 2 in magnitude, which covers the per-fault fields.
+    float maxPerturb = 20.0f;
+    float maxFalloff = falloffDistance * 1.6f;
+    if (!m_perIterationNoise) {
+        maxPerturb = 0.0f;
+        maxFalloff = 0.0f;
+        for(int r = 0; r < rows; ++r) {
+            const float* perturbRow = m_perturbation.row(tile.x0 + r) + tile.z0;
+            const float* falloffRow = m_falloff.row(tile.x0 + r) + tile.z0;
+            for(int k = 0; k < span; ++k) {
+                maxPerturb = std::max(maxPerturb, std::abs(perturbRow[k]));
+                maxFalloff = std::max(maxFalloff, falloffRow[k]);
             }
-            
-            // Apply displacement with falloff
-            if(distance > 0) {
-                heightMap[x][y] += displacement * falloff;
+        }
+    }
+    std::vector<float> faultPerturb, faultFalloff;
+    if (m_perIterationNoise) {
+        faultPerturb.resize(span);
+        faultFalloff.resize(span);
+    }
+
+    // A fault whose perturbed band misses the whole tile just raises or
+    // lowers it, so those only add up into a constant offset
+    const float bandMargin = maxPerturb + maxFalloff + 1e-3f;
+    float offset = 0.0f;
+    std::vector<float> accum(rows * span, 0.0f);
+
+    for (size_t f = 0; f < faults.size(); ++f) {
+        const FaultLine& fault = faults[f];
+        float d00 = fault.a * tile.x0 + fault.b * tile.z0 + fault.c;
+        float d01 = fault.a * tile.x0 + fault.b * (tile.z1 - 1) + fault.c;
+        float d10 = fault.a * (tile.x1 - 1) + fault.b * tile.z0 + fault.c;
+        float d11 = fault.a * (tile.x1 - 1) + fault.b * (tile.z1 - 1) + fault.c;
+        float nearest = std::min(std::min(d00, d01), std::min(d10, d11));
+        float furthest = std::max(std::max(d00, d01), std::max(d10, d11));
+        if (nearest > bandMargin) {
+            offset += fault.displacement;
+            continue;
+        }
+        if (furthest < -bandMargin) {
+            offset -= fault.displacement;
+            continue;
+        }
+
+        for(int r = 0; r < rows; ++r) {
+            const float* perturbRow;
+            const float* falloffRow;
+            if (m_perIterationNoise) {
+                sampleNoiseFields(m_faultNoise[f], tile.x0 + r, tile.z0, span, falloffDistance,
+                                  faultPerturb.data(), faultFalloff.data());
+                perturbRow = faultPerturb.data();
+                falloffRow = faultFalloff.data();
             } else {
-                heightMap[x][y] -= displacement * falloff;
+                perturbRow = m_perturbation.row(tile.x0 + r) + tile.z0;
+                falloffRow = m_falloff.row(tile.x0 + r) + tile.z0;
             }
+            float* accumRow = accum.data() + r * span;
+            float rowDistance = fault.a * (tile.x0 + r) + fault.c;
+
+            simd::forEachLane(span, [&](int k, size_t n, auto partial) {
+                using namespace simd;
+                constexpr bool P = decltype(partial)::value;
+
+                // Perturbed distance calculation
+                vfloat y = iota(static_cast<float>(tile.z0 + k));
+                vfloat distance = set1(rowDistance) + set1(fault.b) * y + loadLanes<P>(perturbRow + k, n);
+                vfloat reach = loadLanes<P>(falloffRow + k, n);
+                vfloat within = abs(distance);
+                vfloat falloff = select(within < reach, cosineFalloff(within / reach), set1(1.0f));
+
+                // Apply displacement with falloff
+                vfloat signedDisplacement = select(distance > set1(0.0f), set1(fault.displacement),
+                                                   set1(-fault.displacement));
+                storeLanes<P>(accumRow + k, loadLanes<P>(accumRow + k, n) + signedDisplacement * falloff, n);
+            });
         }
     }
-}
 
-// Add an erosion pass after generating the base heightmap
-void FaultFormationGenerator::applySimpleErosion(std::vector<std::vector<float>>& heightMap, int iterations) {
-    int width = heightMap.size();
-    int height = heightMap[0].size();
-    
-    std::vector<std::vector<float>> tempMap = heightMap;
-    
-    for (int iter = 0; iter < iterations; ++iter) {
-        #pragma omp parallel for collapse(2)
-        for(int x = 1; x < width - 1; ++x) {
-            for(int y = 1; y < height - 1; ++y) {
-                // Simple thermal erosion - material moves from higher to lower cells
-                float current = heightMap[x][y];
-                float lowestNeighbor = current;
-                int lowestX = x, lowestY = y;
-                
-                // Check all 8 neighbors
-                for (int nx = x-1; nx <= x+1; ++nx) {
-                    for (int ny = y-1; ny <= y+1; ++ny) {
-                        if (nx == x && ny == y) continue;
-                        
-                        if (heightMap[nx][ny] < lowestNeighbor) {
-                            lowestNeighbor = heightMap[nx][ny];
-                            lowestX = nx;
-                            lowestY = ny;
-                        }
-                    }
-                }
-                
-                // If current cell is higher than its lowest neighbor
-                if (current > lowestNeighbor) {
-                    float diff = current - lowestNeighbor;
-                    float amount = std::min(diff * 0.1f, 0.05f); // Limit erosion rate
-                    
-                    tempMap[x][y] -= amount;
-                    tempMap[lowestX][lowestY] += amount;
-                }
-            }
+    for(int r = 0; r < rows; ++r) {
+        const float* accumRow = accum.data() + r * span;
+        float* row = heightMap.row(tile.x0 + r) + tile.z0;
+        for(int k = 0; k < span; ++k) {
+            row[k] = accumRow[k] + offset;
         }
-        
-        heightMap = tempMap;
     }
 }
 
+// Add an erosion pass after generating the base heightmap
 // Add detail with multiple octaves of noise
-void FaultFormationGenerator::addDetailNoise(std::vector<std::vector<float>>& heightMap, float intensity) {
-    int width = heightMap.size();
-    int height = heightMap[0].size();
-    
-    // Set different seed for detail noise
-    m_noise.setSeed(42);
-    
-    #pragma omp parallel for collapse(2)
-    for(int x = 0; x < width; ++x) {
+void FaultFormationGenerator::addDetailNoise(HeightField& heightMap, float intensity) {
+    int width = heightMap.width();
+    int height = heightMap.height();
+
+    // Rows are independent, so bands of them run on the pool, each with its
+    // own sample buffers
+    const int bandRows = HeightField::kTileSize;
+    ThreadPool::global().parallelFor((width + bandRows - 1) / bandRows, [&](int band) {
+        if (cancelled()) {
+            return;
+        }
+        int x0 = band * bandRows;
+        int x1 = std::min(x0 + bandRows, width);
+        std::vector<float> sampleX(height), sampleY(height), detailRow(height);
         for(int y = 0; y < height; ++y) {
-            float detail = m_noise.getOctaveNoise(
-                static_cast<float>(x) * 0.01f, 
-                static_cast<float>(y) * 0.01f,
+            sampleY[y] = static_cast<float>(y) * 0.01f;
+        }
+        for(int x = x0; x < x1; ++x) {
+            std::fill(sampleX.begin(), sampleX.end(), static_cast<float>(x) * 0.01f);
+            m_detailNoise.getOctaveNoise(
+                sampleX.data(), sampleY.data(), detailRow.data(), height,
                 3,  // 3 octaves
                 0.5f  // persistence
             );
-            
-            // Apply detail noise with varying intensity based on height
-            // More detail at higher elevations (mountains) and less in valleys
-            float heightFactor = 0.5f + 0.5f * heightMap[x][y]; // Map [-1,1] to [0,1]
-            heightMap[x][y] += detail * intensity * heightFactor;
+
+            float* row = heightMap.row(x);
+            for(int y = 0; y < height; ++y) {
+                float detail = detailRow[y];
+
+                // Apply detail noise with varying intensity based on height
+                // More detail at higher elevations (mountains) and less in valleys
+                float heightFactor = 0.5f + 0.5f * row[y]; // Map [-1,1] to [0,1]
+                row[y] += detail * intensity * heightFactor;
+            }
         }
-    }
+    });
 }
 
-void FaultFormationGenerator::generateHeightMap(std::vector<std::vector<float>>& heightMap) {
-    // Initialize heightmap to 0
-    for(auto& row : heightMap) {
-        std::fill(row.begin(), row.end(), 0.0f);
-    }
-    
-    // Apply fault formation multiple times
+void FaultFormationGenerator::generateHeightMap(HeightField& heightMap) {
+    buildNoiseFields(heightMap.width(), heightMap.height());
+    checkpoint(0.1f);
+
+    // Draw every fault line up front, then let each tile apply all of them
+    // in one pass while its rows stay in cache
+    std::vector<FaultLine> faults;
+    faults.reserve(m_iterations);
     for(int i = 0; i < m_iterations; ++i) {
-        createFault(heightMap, static_cast<float>(i));
+        faults.push_back(makeFault(heightMap.width(), heightMap.height(), static_cast<float>(i)));
     }
+
+    const int tiles = heightMap.tileCount();
+    std::atomic<int> done{0};
+    ThreadPool::global().parallelFor(tiles, [&](int tile) {
+        if (cancelled()) {
+            return;
+        }
+        applyFaults(heightMap, heightMap.tile(tile), faults);
+        report(0.1f + 0.7f * static_cast<float>(++done) / tiles);
+    });
+    checkpoint(0.8f);
     
     // Apply different levels of detail
     addDetailNoise(heightMap, 0.1f);
     
     // Apply simple erosion simulation
-    applySimpleErosion(heightMap, 5);
+    m_erosion.apply(heightMap);
+    checkpoint(0.95f);
     
     // Normalize heightmap to [-1, 1] range
-    float minHeight = heightMap[0][0];
-    float maxHeight = heightMap[0][0];
-    
-    // Find min and max heights
-    for(const auto& row : heightMap) {
-        for(float height : row) {
-            minHeight = std::min(minHeight, height);
-            maxHeight = std::max(maxHeight, height);
-        }
-    }
+    auto [minHeight, maxHeight] = heightMap.minMax();
     
     // Normalize with non-linear mapping to emphasize terrain features
     float range = maxHeight - minHeight;
-    for(auto& row : heightMap) {
-        for(float& height : row) {
+    for(int x = 0; x < heightMap.width(); ++x) {
+        float* row = heightMap.row(x);
+        for(int z = 0; z < heightMap.height(); ++z) {
+            float& height = row[z];
             // Normalize to [0, 1] first
             float normalizedHeight = (height - minHeight) / range;
             
@@ -425,9 +577,11 @@ void FaultFormationGenerator::generateHeightMap(std::vector<std::vector<float>>&
 
 
 // MidpointDisplacementGenerator Implementation
-MidpointDisplacementGenerator::MidpointDisplacementGenerator(float roughness, float initialDisplacement)
+MidpointDisplacementGenerator::MidpointDisplacementGenerator(float roughness, float initialDisplacement,
+                                                             unsigned int seed)
     : m_roughness(roughness)
-    , m_initialDisplacement(initialDisplacement) {
+    , m_initialDisplacement(initialDisplacement)
+    , m_rng(seed, RngStream::MIDPOINT_DISPLACEMENT) {
     // Validate parameters
     if (roughness < 0.0f) {
         throw std::runtime_error("Roughness must be positive");
@@ -442,152 +596,226 @@ int MidpointDisplacementGenerator::calcNextPowerOfTwo(int size) {
     return power;
 }
 
-float MidpointDisplacementGenerator::randomFloatRange(float min, float max) {
-    return min + (max - min) * (static_cast<float>(rand()) / RAND_MAX);
+float MidpointDisplacementGenerator::randomFloatRange(float min, float max, int rectSize, int x, int z) const {
+    return m_rng.range(min, max, rectSize, x, z);
 }
 
-void MidpointDisplacementGenerator::diamondStep(
-    std::vector<std::vector<float>>& heightMap, 
-    int rectSize, 
-    float curHeight
-) {
-    int halfRectSize = rectSize / 2;
-    int width = heightMap.size();
-
-    for (int y = 0; y < width; y += rectSize) {
-        for (int x = 0; x < width; x += rectSize) {
-            int nextX = (x + rectSize) % width;
-            int nextY = (y + rectSize) % width;
-
-            // Handle wrapping
-            if (nextX < x) {
-                nextX = width - 1;
-            }
-            if (nextY < y) {
-                nextY = width - 1;
-            }
-
-            float topLeft = heightMap[y][x];
-            float topRight = heightMap[y][nextX];
-            float bottomLeft = heightMap[nextY][x];
-            float bottomRight = heightMap[nextY][nextX];
-
-            int midX = (x + halfRectSize) % width;
-            int midY = (y + halfRectSize) % width;
-
-            float randValue = randomFloatRange(-curHeight, curHeight);
-            float midPoint = (topLeft + topRight + bottomLeft + bottomRight) / 4.0f;
-
-            heightMap[midY][midX] = midPoint + randValue;
+void MidpointDisplacementGenerator::diamondRow(HeightField& grid, int x, int rectSize, float curHeight,
+                                               const Lattice& lattice) const {
+    // Centres of the squares whose corners lie on rows x - half and x + half
+    int half = rectSize / 2;
+    const float* up = grid.row(x - half);
+    const float* down = grid.row(x + half);
+    float* row = grid.row(x);
+    int count = (grid.height() - 1) / rectSize;
+    std::uint32_t level = rectSize * lattice.spacing;
+    std::uint32_t mapX = lattice.x0 + x * lattice.spacing;
+
+    // Averages are gathered lane by lane; the hashed offsets are the costly
+    // part and run a whole vector at a time
+    simd::forEachLane(count, [&](int i, std::size_t n, auto) {
+        alignas(32) float lanes[simd::kWidth] = {};
+        for (std::size_t l = 0; l < n; ++l) {
+            int z = half + (i + static_cast<int>(l)) * rectSize;
+            lanes[l] = (up[z - half] + up[z + half] + down[z - half] + down[z + half]) * 0.25f;
         }
-    }
+        simd::vint z = simd::set1i(half) + simd::toInt(simd::iota(static_cast<float>(i))) * simd::set1i(rectSize);
+        simd::vint mapZ = simd::set1i(lattice.z0) + z * simd::set1i(lattice.spacing);
+        simd::store(lanes, simd::load(lanes) + m_rng.range(-curHeight, curHeight, level, mapX, mapZ));
+        for (std::size_t l = 0; l < n; ++l) {
+            row[half + (i + static_cast<int>(l)) * rectSize] = lanes[l];
+        }
+    });
 }
 
-void MidpointDisplacementGenerator::squareStep(
-    std::vector<std::vector<float>>& heightMap, 
-    int rectSize, 
-    float curHeight
-) {
-    /*                ----------------------------------
-                      |                                |
-                      |           PrevYCenter          |
-                      |                                |
-                      |                                |
-                      |                                |
-    ------------------CurTopLeft..CurTopMid..CurTopRight
-                      |                                |
-                      |                                |
-       CurPrevXCenter CurLeftMid   CurCenter           |
-                      |                                |
-                      |                                |
-                      CurBotLeft------------------------
+void MidpointDisplacementGenerator::squareRow(HeightField& grid, int x, int rectSize, float curHeight,
+                                              const Lattice& lattice) const {
+    /*  Corner row (x % rectSize == 0):   Centre row:
 
-       CurTopMid = avg(PrevYCenter, CurTopLeft, CurTopRight, CurCenter)
-       CurLeftMid = avg(CurPrevXCenter, CurTopLeft, CurBotLeft, CurCenter)
-    */
-
-    int halfRectSize = rectSize / 2;
-    int width = heightMap.size();
-
-    for (int y = 0; y < width; y += rectSize) {
-        for (int x = 0; x < width; x += rectSize) {
-            int nextX = (x + rectSize) % width;
-            int nextY = (y + rectSize) % width;
+        C . . M . . C                     C
+              |                           |
+              D                     D --- M --- D
+                                          |
+                                          C
 
-            // Handle wrapping
-            if (nextX < x) {
-                nextX = width - 1;
-            }
-            if (nextY < y) {
-                nextY = width - 1;
+       M = avg of the points half a step away (C corners, D diamond centres).
+       On the grid's own border, the outside of everything generated, only
+       the two points along the edge are used.
+    */
+    int half = rectSize / 2;
+    int last = grid.height() - 1;
+    bool edgeRow = x == 0 || x == grid.width() - 1;
+    int first = (x % rectSize == 0) ? half : 0;
+    const float* up = edgeRow ? nullptr : grid.row(x - half);
+    const float* down = edgeRow ? nullptr : grid.row(x + half);
+    float* row = grid.row(x);
+    int count = (last - first) / rectSize + 1;
+    std::uint32_t level = rectSize * lattice.spacing;
+    std::uint32_t mapX = lattice.x0 + x * lattice.spacing;
+
+    simd::forEachLane(count, [&](int i, std::size_t n, auto) {
+        alignas(32) float lanes[simd::kWidth] = {};
+        for (std::size_t l = 0; l < n; ++l) {
+            int z = first + (i + static_cast<int>(l)) * rectSize;
+            if (z == 0 || z == last) {
+                lanes[l] = (up[z] + down[z]) * 0.5f;
+            } else if (edgeRow) {
+                lanes[l] = (row[z - half] + row[z + half]) * 0.5f;
+            } else {
+                lanes[l] = (up[z] + down[z] + row[z - half] + row[z + half]) * 0.25f;
             }
+        }
+        simd::vint z = simd::set1i(first) + simd::toInt(simd::iota(static_cast<float>(i))) * simd::set1i(rectSize);
+        simd::vint mapZ = simd::set1i(lattice.z0) + z * simd::set1i(lattice.spacing);
+        simd::store(lanes, simd::load(lanes) + m_rng.range(-curHeight, curHeight, level, mapX, mapZ));
+        for (std::size_t l = 0; l < n; ++l) {
+            row[first + (i + static_cast<int>(l)) * rectSize] = lanes[l];
+        }
+    });
+}
 
-            int midX = (x + halfRectSize) % width;
-            int midY = (y + halfRectSize) % width;
-                
-            int prevMidX = (x - halfRectSize + width) % width;
-            int prevMidY = (y - halfRectSize + width) % width;
-
-            float curTopLeft = heightMap[y][x];
-            float curTopRight = heightMap[y][nextX];
-            float curCenter = heightMap[midY][midX];
-            float prevYCenter = heightMap[prevMidY][midX];
-            float curBotLeft = heightMap[nextY][x]; 
-            float prevXCenter = heightMap[midY][prevMidX];
+void MidpointDisplacementGenerator::subdivide(HeightField& grid, int rectSize, float curHeight,
+                                              const Lattice& lattice) const {
+    // Within a level every diamond update is independent, and so is every
+    // square update; offsets are hashed from the position, so any order works.
+    // A band is a run of square rows swept top to bottom: the diamond centres
+    // of one row, the square points beside them, then the square points on
+    // the corner row above, whose diamonds on both sides are now done. Bands
+    // are about a tile high, so on the fine levels, where nearly all the work
+    // is, the rows a band touches are still in cache when it comes back.
+    int half = rectSize / 2;
+    int last = grid.width() - 1;
+    int units = last / rectSize;
+    int bandUnits = std::max(1, HeightField::kTileSize / rectSize);
+    int bands = (units + bandUnits - 1) / bandUnits;
+
+    ThreadPool& pool = ThreadPool::global();
+    pool.parallelFor(bands, [&](int band) {
+        if (cancelled()) {
+            return;
+        }
+        int first = band * bandUnits;
+        int end = std::min(first + bandUnits, units);
+        for (int unit = first; unit < end; ++unit) {
+            int x = unit * rectSize;
+            diamondRow(grid, x + half, rectSize, curHeight, lattice);
+            squareRow(grid, x + half, rectSize, curHeight, lattice);
+            // A band's top corner row waits for the diamonds of the band above
+            if (unit > first || unit == 0) {
+                squareRow(grid, x, rectSize, curHeight, lattice);
+            }
+        }
+        if (end == units) {
+            squareRow(grid, last, rectSize, curHeight, lattice);
+        }
+    });
 
-            float curLeftMid = (curTopLeft + curCenter + curBotLeft + prevXCenter) / 4.0f + 
-                               randomFloatRange(-curHeight, curHeight);
-            float curTopMid = (curTopLeft + curCenter + curTopRight + prevYCenter) / 4.0f + 
-                              randomFloatRange(-curHeight, curHeight);
+    pool.parallelFor(bands - 1, [&](int band) {
+        squareRow(grid, (band + 1) * bandUnits * rectSize, rectSize, curHeight, lattice);
+    });
+}
 
-            heightMap[y][midX] = curTopMid;
-            heightMap[midY][x] = curLeftMid;
-        }
+void MidpointDisplacementGenerator::generateHeightMap(HeightField& heightMap) {
+    int width = heightMap.width();
+    int height = heightMap.height();
+    if (heightMap.empty()) {
+        return;
     }
-}
 
-void MidpointDisplacementGenerator::generateHeightMap(std::vector<std::vector<float>>& heightMap) {
-    int width = heightMap.size();
-    
-    // Calculate rectangle size (power of 2)
-    int rectSize = calcNextPowerOfTwo(width);
+    // Only the tiles covering the map are generated. Their corners are a
+    // coarse diamond-square lattice one point per tile, continuing the same
+    // displacement schedule down to the tile size.
+    int tilesX = std::max(1, (width - 2) / kTileSize + 1);
+    int tilesZ = std::max(1, (height - 2) / kTileSize + 1);
+    int coarseSize = calcNextPowerOfTwo(std::max(tilesX, tilesZ) + 1) + 1;
+    HeightField corners(coarseSize, coarseSize);
+    const Lattice coarse{0, 0, kTileSize};
+
     float curHeight = m_initialDisplacement;
     float heightReduce = std::pow(2.0f, -m_roughness);
+    int last = coarseSize - 1;
     
     // Initialize corners with random values
-    heightMap[0][0] = randomFloatRange(-curHeight, curHeight);
-    heightMap[0][width-1] = randomFloatRange(-curHeight, curHeight);
-    heightMap[width-1][0] = randomFloatRange(-curHeight, curHeight);
-    heightMap[width-1][width-1] = randomFloatRange(-curHeight, curHeight);
-    
-    // Main generation loop
-    while (rectSize > 0) {
-        diamondStep(heightMap, rectSize, curHeight);
-        squareStep(heightMap, rectSize, curHeight);
-        
-        rectSize /= 2;
+    corners(0, 0) = randomFloatRange(-curHeight, curHeight, 0, 0, 0);
+    corners(0, last) = randomFloatRange(-curHeight, curHeight, 0, 0, last * kTileSize);
+    corners(last, 0) = randomFloatRange(-curHeight, curHeight, 0, last * kTileSize, 0);
+    corners(last, last) = randomFloatRange(-curHeight, curHeight, 0, last * kTileSize, last * kTileSize);
+    for (int rectSize = last; rectSize > 1; rectSize /= 2) {
+        subdivide(corners, rectSize, curHeight, coarse);
         curHeight *= heightReduce;
     }
-    
-    // Normalize heightmap to [-1, 1] range
-    float minHeight = heightMap[0][0];
-    float maxHeight = heightMap[0][0];
 
-    // Find min and max heights
-    for (const auto& row : heightMap) {
-        for (float height : row) {
-            minHeight = std::min(minHeight, height);
-            maxHeight = std::max(maxHeight, height);
+    // The levels below the tile size then run across all the tiles at once,
+    // so a tile seam is an ordinary interior point with four neighbours.
+    // Only the covering grid, at most a tile larger than the map on each
+    // axis, is allocated; a map that is already that size is used in place.
+    int gridWidth = tilesX * kTileSize + 1;
+    int gridHeight = tilesZ * kTileSize + 1;
+    HeightField grid;
+    bool inPlace = gridWidth == width && gridHeight == height;
+    if (!inPlace) {
+        grid.resize(gridWidth, gridHeight);
+    }
+    HeightField& target = inPlace ? heightMap : grid;
+    for (int tileX = 0; tileX <= tilesX; ++tileX) {
+        for (int tileZ = 0; tileZ <= tilesZ; ++tileZ) {
+            target(tileX * kTileSize, tileZ * kTileSize) = corners(tileX, tileZ);
         }
     }
 
-    // Normalize
-    float range = maxHeight - minHeight;
-    for (auto& row : heightMap) {
-        for (float& height : row) {
-            height = 2.0f * (height - minHeight) / range - 1.0f;
+    const Lattice fine{0, 0, 1};
+    int levels = 0;
+    for (int rectSize = kTileSize; rectSize > 1; rectSize /= 2) {
+        ++levels;
+    }
+    int level = 0;
+    for (int rectSize = kTileSize; rectSize > 1; rectSize /= 2) {
+        subdivide(target, rectSize, curHeight, fine);
+        curHeight *= heightReduce;
+        checkpoint(0.9f * static_cast<float>(++level) / levels);
+    }
+
+    // Crop and find the range per band of rows, then normalize to [-1, 1]
+    ThreadPool& pool = ThreadPool::global();
+    const int bandRows = HeightField::kTileSize;
+    int bands = (width + bandRows - 1) / bandRows;
+    std::vector<std::pair<float, float>> bandRange(bands);
+    pool.parallelFor(bands, [&](int band) {
+        int x0 = band * bandRows;
+        int x1 = std::min(x0 + bandRows, width);
+        float lo = std::numeric_limits<float>::max();
+        float hi = std::numeric_limits<float>::lowest();
+        for (int x = x0; x < x1; ++x) {
+            float* row = heightMap.row(x);
+            if (!inPlace) {
+                std::copy(grid.row(x), grid.row(x) + height, row);
+            }
+            for (int z = 0; z < height; ++z) {
+                lo = std::min(lo, row[z]);
+                hi = std::max(hi, row[z]);
+            }
         }
+        bandRange[band] = {lo, hi};
+    });
+
+    float minHeight = bandRange[0].first;
+    float maxHeight = bandRange[0].second;
+    for (const auto& [lo, hi] : bandRange) {
+        minHeight = std::min(minHeight, lo);
+        maxHeight = std::max(maxHeight, hi);
     }
+
+    float range = maxHeight - minHeight;
+    pool.parallelFor(bands, [&](int band) {
+        int x0 = band * bandRows;
+        int x1 = std::min(x0 + bandRows, width);
+        for (int x = x0; x < x1; ++x) {
+            float* row = heightMap.row(x);
+            for (int z = 0; z < height; ++z) {
+                row[z] = 2.0f * (row[z] - minHeight) / range - 1.0f;
+            }
+        }
+    });
 }
 
 
@@ -598,254 +826,585 @@ Terrain::Terrain(float yScale, float yShift, int resolution,
                  int width, int height,
                  int octaves, float persistence, float frequency,
                  int iterations, float minDelta, float maxDelta,
-                 float roughness, float initialDisplacement)
+                 float roughness, float initialDisplacement,
+                 int erosionDroplets, int erosionSteps,
+                 unsigned int seed)
     : m_VAO(0)
-    , m_VBO(0)
-    , m_IBO(0)
     , m_width(width)
     , m_height(height)
+    , m_resolution(std::clamp(resolution, 1, kChunkSize))
     , m_yScale(yScale)
     , m_yShift(yShift)
-    , m_resolution(resolution)
-    , m_numStrips(0)
-    , m_numTrisPerStrip(0)
-    , m_octaves(octaves)
-    , m_persistence(persistence)
-    , m_frequency(frequency)
-    , m_iterations(iterations)
-    , m_minDelta(minDelta)
-    , m_maxDelta(maxDelta)
-    , m_roughness(roughness)
-    , m_initialDisplacement(initialDisplacement)
-    , heightMap(width, std::vector<float>(height, 0.0f))
-    , currentHeightMap(width, std::vector<float>(height, 0.0f))
-    , heightMaps(static_cast<int>(GenerationType::COUNT),std::vector<std::vector<float>>(width, std::vector<float>(height, 0.0f))){
+    , m_settings{octaves, persistence, frequency,
+                 iterations, minDelta, maxDelta,
+                 roughness, initialDisplacement,
+                 erosionDroplets, erosionSteps,
+                 seed, Compositor()} {
     initializeGLBuffers();
+    buildIndexLevel(1);
+    buildIndexLevel(m_resolution);
 }
 
 float Terrain::getYScale() const { return m_yScale; }
 float Terrain::getYShift() const { return m_yShift; }
 float Terrain::getheightMin() const { return m_heightMin; }
 float Terrain::getheightMax() const { return m_heightMax; }
+unsigned int Terrain::getSeed() const { return m_settings.seed; }
+
+void Terrain::setHeightScale(float yScale, float yShift) {
+    m_yScale = yScale;
+    m_yShift = yShift;
+}
+
+void Terrain::setResolution(int resolution) {
+    m_resolution = std::clamp(resolution, 1, kChunkSize);
+    buildIndexLevel(m_resolution);
+}
+
+void Terrain::setLevelOfDetail(bool enabled, float pixelError) {
+    m_lodEnabled = enabled;
+    m_lodPixelError = std::max(pixelError, 0.1f);
+}
 
-void Terrain::setTerrainGenerator(GenerationType type) {
+void Terrain::setPerlinParams(float frequency, int octaves, float persistence) {
+    m_settings.frequency = frequency;
+    m_settings.octaves = octaves;
+    m_settings.persistence = persistence;
+}
+
+void Terrain::setFaultParams(int iterations, float minDelta, float maxDelta) {
+    m_settings.iterations = iterations;
+    m_settings.minDelta = minDelta;
+    m_settings.maxDelta = maxDelta;
+}
+
+void Terrain::setMidpointParams(float roughness, float initialDisplacement) {
+    m_settings.roughness = roughness;
+    m_settings.initialDisplacement = initialDisplacement;
+}
+
+void Terrain::setErosion(int droplets, int steps) {
+    m_settings.erosionDroplets = droplets;
+    m_settings.erosionSteps = steps;
+}
+
+void Terrain::setSeed(unsigned int seed) {
+    m_settings.seed = seed;
+}
+
+void Terrain::setCompositor(const Compositor& compositor) {
+    m_settings.compositor = compositor;
+}
+
+std::unique_ptr<TerrainGenerator> Terrain::makeGenerator(GenerationType type, const Settings& settings) const {
     switch(type) {
         case GenerationType::PERLIN_NOISE:
-            m_currentGenerator = std::make_unique<PerlinNoiseGenerator>(m_frequency, m_octaves, m_persistence);
+            return std::make_unique<PerlinNoiseGenerator>(settings.frequency, settings.octaves,
+                                                          settings.persistence, settings.seed);
+        case GenerationType::FAULT_FORMATION:
+            return std::make_unique<FaultFormationGenerator>(settings.iterations, settings.minDelta,
+                                                             settings.maxDelta, settings.seed);
+        case GenerationType::MIDPOINT_DISPLACEMENT:
+            return std::make_unique<MidpointDisplacementGenerator>(settings.roughness, settings.initialDisplacement,
+                                                                   settings.seed);
+        default:
+            throw std::runtime_error("Unknown terrain generation type");
+    }
+}
+
+std::uint64_t Terrain::baseKey(GenerationType type, const Settings& settings) const {
+    StageKey key;
+    key.add(type).add(m_width).add(m_height).add(settings.seed);
+    switch(type) {
+        case GenerationType::PERLIN_NOISE:
+            key.add(settings.frequency).add(settings.octaves).add(settings.persistence);
             break;
         case GenerationType::FAULT_FORMATION:
-            m_currentGenerator = std::make_unique<FaultFormationGenerator>(m_iterations, m_minDelta, m_maxDelta);
+            key.add(settings.iterations).add(settings.minDelta).add(settings.maxDelta);
             break;
         case GenerationType::MIDPOINT_DISPLACEMENT:
-            m_currentGenerator = std::make_unique<MidpointDisplacementGenerator>(0.5f, 1.0f);
+            key.add(settings.roughness).add(settings.initialDisplacement);
             break;
         default:
             throw std::runtime_error("Unknown terrain generation type");
     }
+    return key.value();
 }
 
-void Terrain::addedTerrain(){
-    for (int i = 0; i < static_cast<int>(GenerationType::COUNT); ++i) {
-        GenerationType type = static_cast<GenerationType>(i);
+const HeightField& Terrain::baseLayer(GenerationType type, std::uint64_t key, const Settings& settings,
+                                      GenerationControl& control) {
+    return m_baseStage[static_cast<int>(type)].get(key, [&](HeightField& layer) {
+        layer.resize(m_width, m_height);
+        std::unique_ptr<TerrainGenerator> generator = makeGenerator(type, settings);
+        generator->setControl(&control);
+        generator->generateHeightMap(layer);
+    });
+}
 
-        setTerrainGenerator(type);  
+void Terrain::requestTerrain(GenerationType type) {
+    request(Request{type, false});
+}
 
-        if (!m_currentGenerator) {
-            throw std::runtime_error("No terrain generator selected");
-        }
+void Terrain::requestAddedTerrain() {
+    request(Request{GenerationType::COUNT, true});
+}
 
-        m_currentGenerator->generateHeightMap(heightMap);
-        for(int x=0; x<m_width; x++)
-        {
-            for(int z=0; z<m_height; z++){
-                heightMaps[i][x][z]=heightMap[x][z]; 
-            }
-        }
+void Terrain::request(const Request& request) {
+    if (m_job.valid()) {
+        // Superseded; poll() starts the newest request once the run stops
+        m_control->cancel();
+        m_pending = request;
+        return;
     }
+    startJob(request);
+}
 
-    maxMaps();
+void Terrain::startJob(const Request& request) {
+    m_control = std::make_shared<GenerationControl>();
+    m_job = std::async(std::launch::async, [this, request, settings = m_settings, control = m_control]() {
+        return runJob(request, settings, *control);
+    });
+}
 
+bool Terrain::poll() {
+    if (!m_job.valid()) {
+        return false;
+    }
+    if (m_job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+
+    bool swapped = false;
     try {
-        generateVertexArray(currentHeightMap);
-        generateIndices();
-        setupBuffers();
-    } catch (const std::exception& e) {
+        MeshUpdate update = m_job.get();
+        if (update.heights) {
+            setupBuffers(*update.heights);
+            m_nodeHeights = std::move(update.nodeHeights);
+        }
+        m_heightMin = update.heightMin;
+        m_heightMax = update.heightMax;
+        swapped = true;
+    } catch (const GenerationCancelled&) {
+        // Superseded by m_pending
+    } catch (...) {
+        m_pending.reset();
         throw;
-    }    
+    }
+
+    if (m_pending) {
+        Request next = *m_pending;
+        m_pending.reset();
+        startJob(next);
+    }
+    return swapped;
 }
 
-void Terrain::addMaps(){
-    for(int i =0; i< static_cast<int>(GenerationType::COUNT); i++){
-        for(int x=0; x<m_width; x++)
-        {
-            for(int z=0; z<m_height; z++){
-                currentHeightMap[x][z]+=heightMaps[i][x][z]; 
-            }
-        }
+void Terrain::waitForJobs() {
+    while (m_job.valid()) {
+        m_job.wait();
+        poll();
     }
 }
 
-void Terrain::maxMaps(){
-    for(int i =0; i< static_cast<int>(GenerationType::COUNT); i++){
-        for(int x=0; x<m_width; x++)
-        {
-            for(int z=0; z<m_height; z++){
-                currentHeightMap[x][z]=std::max(currentHeightMap[x][z], heightMaps[i][x][z]); 
-            }
-        }
+void Terrain::stopGeneration() {
+    m_pending.reset();
+    if (m_job.valid()) {
+        m_control->cancel();
+        m_job.wait();
+        poll();
     }
 }
 
-void Terrain::weightedAddMaps(){
-    std::vector<float> weights = {0.1f, 0.1f, 0.8f};
-    for(int i =0; i< static_cast<int>(GenerationType::COUNT); i++){
-        for(int x=0; x<m_width; x++)
-        {
-            for(int z=0; z<m_height; z++){
-                currentHeightMap[x][z]+=weights[i] * heightMaps[i][x][z]; 
-            }
-        }
-    }    
+bool Terrain::isGenerating() const {
+    return m_job.valid();
 }
 
+float Terrain::getProgress() const {
+    return m_control ? m_control->progress() : 0.0f;
+}
 
 void Terrain::generateTerrain(GenerationType type) {
-    setTerrainGenerator(type);
-    
-    if (!m_currentGenerator) {
-        throw std::runtime_error("No terrain generator selected");
-    }
-    
-    m_currentGenerator->generateHeightMap(heightMap);
-
-    m_heightMin = heightMap[0][0];
-    m_heightMax = heightMap[0][0];
-    for (const auto& row : heightMap) {
-        for (float height : row) {
-            m_heightMin = std::min(m_heightMin, height);
-            m_heightMax = std::max(m_heightMax, height);
-        }
-    }    
-
-    
-    try {
-        generateVertexArray(heightMap);
-        generateIndices();
-        setupBuffers();
-    } catch (const std::exception& e) {
-        throw;
-    }
+    requestTerrain(type);
+    waitForJobs();
 }
 
-void Terrain::initializeGLBuffers() {
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_IBO);
+void Terrain::addedTerrain() {
+    requestAddedTerrain();
+    waitForJobs();
 }
 
-void Terrain::generateVertexArray(std::vector<std::vector<float>>& heightMap) {
-    m_vertexArray.clear();
-    m_vertexArray.reserve(m_width * m_height * 5);
+Terrain::MeshUpdate Terrain::runJob(const Request& request, const Settings& settings, GenerationControl& control) {
+    if (request.layered) {
+        // The generators share nothing but the thread pool, so each dirty
+        // layer runs as its own task; their inner parallelFor calls spread
+        // over whichever workers are free
+        const int layerCount = static_cast<int>(GenerationType::COUNT);
+        std::vector<std::uint64_t> keys(layerCount);
+        StageKey compositeKey;
+        for (int i = 0; i < layerCount; ++i) {
+            keys[i] = baseKey(static_cast<GenerationType>(i), settings);
+            compositeKey.add(keys[i]);
+        }
+
+        // Each layer reports into its own share of the range, so the bar
+        // shows the layers' mean progress rather than the fastest one's
+        control.setRange(0.0f, 0.9f);
+        std::vector<std::unique_ptr<GenerationControl>> layerControls;
+        for (int i = 0; i < layerCount; ++i) {
+            layerControls.push_back(std::make_unique<GenerationControl>(control, 1.0f / layerCount));
+        }
+        std::vector<const HeightField*> layers(layerCount);
+        std::vector<std::exception_ptr> errors(layerCount);
+        ThreadPool::global().parallelFor(layerCount, [&](int i) {
+            try {
+                layers[i] = &baseLayer(static_cast<GenerationType>(i), keys[i], settings, *layerControls[i]);
+                // Cached layers never report, so count them as done here
+                layerControls[i]->report(1.0f);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
 
-    for(int x = 0; x < m_height; x++) {
-        for(int z = 0; z < m_width; z++) {
-            float height = heightMap[x][z] * m_yScale - m_yShift;            
-            m_vertexArray.push_back(-m_height/2.0f + x);
-            m_vertexArray.push_back(height);
-            m_vertexArray.push_back(-m_width/2.0f + z);
-            m_vertexArray.push_back(static_cast<float>(x) / (m_height - 1) * 10);
-            m_vertexArray.push_back(static_cast<float>(z) / (m_width - 1) * 10);
+        const Compositor& compositor = settings.compositor;
+        compositeKey.add(compositor.getOp()).add(compositor.getSmoothness());
+        for (float weight : compositor.getWeights()) {
+            compositeKey.add(weight);
         }
+        control.setRange(0.9f, 0.95f);
+        const HeightField& composite = m_compositeStage.get(compositeKey.value(), [&](HeightField& target) {
+            target.resize(m_width, m_height);
+            compositor.apply(target, layers);
+        });
+
+        control.checkpoint(1.0f);
+        return buildMesh(composite, compositeKey.value());
     }
-}
 
-void Terrain::generateIndices() {
-    m_indices.clear();
-    m_indices.reserve((m_height - 1) * m_width * 2);
+    GenerationType type = request.type;
+    std::uint64_t key = baseKey(type, settings);
+    control.setRange(0.0f, 0.7f);
+    const HeightField& base = baseLayer(type, key, settings, control);
+
+    key = StageKey().add(key).add(settings.erosionDroplets).add(settings.seed)
+                    .add(settings.erosionSteps).value();
+    const HeightField& eroded = m_erosionStage[static_cast<int>(type)].get(key, [&](HeightField& heightMap) {
+        heightMap = base;
+        control.setRange(0.7f, 0.8f);
+        HydraulicErosion(settings.erosionDroplets, settings.seed).apply(heightMap, &control);
+        control.setRange(0.8f, 0.95f);
+        PipeErosion(settings.erosionSteps).apply(heightMap, &control);
+    });
+
+    control.setRange(0.95f, 1.0f);
+    control.checkpoint(0.0f);
+    return buildMesh(eroded, key);
+}
 
-    for(int i = 0; i < m_height-1; i++) {
-        for(int j = 0; j < m_width; j++) {
-            for(int k = 0; k < 2; k++) {
-                m_indices.push_back(j + m_width * (i + k));
+Terrain::MeshUpdate Terrain::buildMesh(const HeightField& heightMap, std::uint64_t key) {
+    MeshUpdate update;
+    std::tie(update.heightMin, update.heightMax) = heightMap.minMax();
+    if (!m_heightStamp.update(key)) {
+        return update;
+    }
+    update.heights = &heightMap;
+
+    // Chunks share their edge rows, so each range includes the next chunk's first row
+    int chunkRows = std::max(1, (heightMap.width() - 2) / kChunkSize + 1);
+    int chunkColumns = std::max(1, (heightMap.height() - 2) / kChunkSize + 1);
+    std::vector<std::pair<float, float>> chunkHeights(static_cast<std::size_t>(chunkRows) * chunkColumns);
+    ThreadPool::global().parallelFor(chunkRows * chunkColumns, [&](int chunk) {
+        int x0 = (chunk / chunkColumns) * kChunkSize;
+        int z0 = (chunk % chunkColumns) * kChunkSize;
+        int x1 = std::min(x0 + kChunkSize, heightMap.width() - 1);
+        int z1 = std::min(z0 + kChunkSize, heightMap.height() - 1);
+        float lo = heightMap(x0, z0);
+        float hi = lo;
+        for (int x = x0; x <= x1; ++x) {
+            const float* row = heightMap.row(x);
+            for (int z = z0; z <= z1; ++z) {
+                lo = std::min(lo, row[z]);
+                hi = std::max(hi, row[z]);
             }
         }
+        chunkHeights[chunk] = {lo, hi};
+    });
+
+    // Quadtree levels up to a single root; nodes past the edge of an odd
+    // sized level just have fewer children
+    update.nodeHeights.push_back(std::move(chunkHeights));
+    int rows = chunkRows;
+    int columns = chunkColumns;
+    while (rows > 1 || columns > 1) {
+        const auto& below = update.nodeHeights.back();
+        int parentRows = (rows + 1) / 2;
+        int parentColumns = (columns + 1) / 2;
+        std::vector<std::pair<float, float>> parents(static_cast<std::size_t>(parentRows) * parentColumns);
+        for (int i = 0; i < parentRows; ++i) {
+            for (int j = 0; j < parentColumns; ++j) {
+                auto range = below[(2 * i) * columns + 2 * j];
+                for (int child = 1; child < 4; ++child) {
+                    int ci = 2 * i + child / 2;
+                    int cj = 2 * j + child % 2;
+                    if (ci < rows && cj < columns) {
+                        range.first = std::min(range.first, below[ci * columns + cj].first);
+                        range.second = std::max(range.second, below[ci * columns + cj].second);
+                    }
+                }
+                parents[i * parentColumns + j] = range;
+            }
+        }
+        update.nodeHeights.push_back(std::move(parents));
+        rows = parentRows;
+        columns = parentColumns;
     }
-    
-    m_numStrips = (m_height-1)/m_resolution;
-    m_numTrisPerStrip = (m_width/m_resolution)*2-2;
+    return update;
 }
 
-void Terrain::setupBuffers() {
-    if (m_vertexArray.empty() || m_indices.empty()) {
-        throw std::runtime_error("No vertex or index data to upload to GPU");
-    }
+void Terrain::initializeGLBuffers() {
+    glGenVertexArrays(1, &m_VAO);
+    glGenTextures(1, &m_heightTexture);
 
+    // Per-patch attributes, refilled every frame by render()
+    glGenBuffers(1, &m_instanceBuffer);
     glBindVertexArray(m_VAO);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, m_vertexArray.size() * sizeof(float), m_vertexArray.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PatchInstance),
+                          reinterpret_cast<void*>(offsetof(PatchInstance, x0)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(PatchInstance),
+                          reinterpret_cast<void*>(offsetof(PatchInstance, morphStart)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5* sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);    
+void Terrain::buildIndexLevel(int stride) {
+    if (m_indexLevels.count(stride)) {
+        return;
+    }
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5* sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);       
+    // Sampled rows and columns of a chunk; the last one is always kept so
+    // neighbouring chunks meet
+    std::vector<int> samples;
+    for (int i = 0; i < kChunkSize; i += stride) {
+        samples.push_back(i);
+    }
+    samples.push_back(kChunkSize);
+
+    // Chunk-local vertex x * (kChunkSize + 1) + z; (kChunkSize + 1)^2 fits in 16 bits
+    const int chunkVertices = kChunkSize + 1;
+    std::vector<unsigned short> indices;
+    indices.reserve(samples.size() * samples.size() * 2 + samples.size() * 2);
+    for (std::size_t i = 0; i + 1 < samples.size(); i++) {
+        if (i > 0) {
+            // Degenerate join to the next row; each row has an even number
+            // of indices, so the winding carries over
+            indices.push_back(indices.back());
+            indices.push_back(static_cast<unsigned short>(samples[i] * chunkVertices + samples[0]));
+        }
+        for (int z : samples) {
+            indices.push_back(static_cast<unsigned short>(samples[i] * chunkVertices + z));
+            indices.push_back(static_cast<unsigned short>(samples[i + 1] * chunkVertices + z));
+        }
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
-    
-    
+    IndexLevel level;
+    level.count = static_cast<GLsizei>(indices.size());
+    level.triangles = static_cast<int>((samples.size() - 1) * (samples.size() - 1) * 2);
+    glGenBuffers(1, &level.buffer);
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level.buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    m_indexLevels.emplace(stride, level);
+}
 
+void Terrain::clearIndexLevels() {
+    for (auto& entry : m_indexLevels) {
+        glDeleteBuffers(1, &entry.second.buffer);
+    }
+    m_indexLevels.clear();
 }
 
-void Terrain::initTexture(Shader& shader, const std::vector<const char*>& texturePaths) {
-    unsigned int textures[texturePaths.size()];  
-    glGenTextures(texturePaths.size(), textures);
+void Terrain::setupBuffers(const HeightField& heights) {
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+    if (heights.width() != m_textureRows || heights.height() != m_textureColumns) {
+        // texelFetch only, so no filtering or mipmaps
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, heights.height(), heights.width(), 0,
+                     GL_RED, GL_FLOAT, nullptr);
+        m_textureRows = heights.width();
+        m_textureColumns = heights.height();
+        m_chunkRows = std::max(1, (m_textureRows - 2) / kChunkSize + 1);
+        m_chunkColumns = std::max(1, (m_textureColumns - 2) / kChunkSize + 1);
+    }
+    uploadHeights(heights, TileRange{0, heights.width(), 0, heights.height()});
+}
+
+void Terrain::uploadHeights(const HeightField& heightMap, const TileRange& region) {
+    // Texture row x is map row x; the padded rows go up as they are
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(heightMap.stride()));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, region.z0, region.x0, region.z1 - region.z0, region.x1 - region.x0,
+                    GL_RED, GL_FLOAT, heightMap.row(region.x0) + region.z0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void Terrain::initTexture(Shader& shader, TextureCache& textures, const std::string& cookedPath,
+                          const std::vector<std::string>& texturePaths) {
+    m_materials = textures.getArray(cookedPath, texturePaths);
     shader.use();
+    shader.setInt("materials", 0);
+    shader.setInt("heightMap", 1);
+}
 
-    for(int i=0; i< texturePaths.size(); i++){
-        glActiveTexture(GL_TEXTURE0 + i); //
-        glBindTexture(GL_TEXTURE_2D, textures[i]);
+void Terrain::nodeBounds(int level, int i, int j, glm::vec3& lo, glm::vec3& hi) const {
+    // Matches the placement in terrain.vert; nodes past the map edge are clipped
+    int nodeSize = kChunkSize << level;
+    int columns = (m_chunkColumns + (1 << level) - 1) >> level;
+    int x0 = i * nodeSize;
+    int z0 = j * nodeSize;
+    int x1 = std::min(x0 + nodeSize, m_textureRows - 1);
+    int z1 = std::min(z0 + nodeSize, m_textureColumns - 1);
+    const auto& heights = m_nodeHeights[level][i * columns + j];
+    float y0 = heights.first * m_yScale - m_yShift;
+    float y1 = heights.second * m_yScale - m_yShift;
+    lo = glm::vec3(-m_textureRows / 2.0f + x0, std::min(y0, y1), -m_textureColumns / 2.0f + z0);
+    hi = glm::vec3(-m_textureRows / 2.0f + x1, std::max(y0, y1), -m_textureColumns / 2.0f + z1);
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
-        int widthImg, heightImg, nrChannels;
-        unsigned char *data = stbi_load(texturePaths[i], &widthImg, &heightImg, &nrChannels, 0);
+void Terrain::selectNode(int level, int i, int j, const Frustum& frustum, const glm::vec3& cameraPosition,
+                         const std::vector<float>& ranges,
+                         std::vector<std::pair<float, PatchInstance>>& patches) const {
+    glm::vec3 lo, hi;
+    nodeBounds(level, i, j, lo, hi);
+    if (!frustum.intersects(lo, hi)) {
+        return;
+    }
 
-        if(data){
-            std::cout<<"yes texture"<<std::to_string(i)<<std::endl;
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, widthImg, heightImg, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+    // Refine while any part of the node is within the next finer level's range
+    glm::vec3 nearest = glm::clamp(cameraPosition, lo, hi) - cameraPosition;
+    float distanceSquared = glm::dot(nearest, nearest);
+    if (level > 0 && distanceSquared < ranges[level - 1] * ranges[level - 1]) {
+        int rows = (m_chunkRows + (1 << (level - 1)) - 1) >> (level - 1);
+        int columns = (m_chunkColumns + (1 << (level - 1)) - 1) >> (level - 1);
+        for (int child = 0; child < 4; ++child) {
+            int ci = 2 * i + child / 2;
+            int cj = 2 * j + child % 2;
+            if (ci < rows && cj < columns) {
+                selectNode(level - 1, ci, cj, frustum, cameraPosition, ranges, patches);
+            }
         }
-        else{
-            std::cout<<"no texture"<<std::to_string(i)<<std::endl;
-        }    
-
-        stbi_image_free(data);  
-        shader.setInt("ourTexture"+std::to_string(i+1), i);
+        return;
     }
 
+    // Children outside their own range morph all the way to this node's
+    // grid, so drawing them at their level instead of as part of the
+    // parent's patch still leaves no cracks
+    PatchInstance patch;
+    patch.x0 = static_cast<float>(i * (kChunkSize << level));
+    patch.z0 = static_cast<float>(j * (kChunkSize << level));
+    patch.spacing = static_cast<float>(1 << level);
+    patch.morphEnd = ranges[level];
+    float previous = level > 0 ? ranges[level - 1] : 0.0f;
+    patch.morphStart = previous + kMorphStart * (patch.morphEnd - previous);
+    glm::vec3 offset = (lo + hi) * 0.5f - cameraPosition;
+    patches.push_back({glm::dot(offset, offset), patch});
 }
 
-void Terrain::render() const {
-    glBindVertexArray(m_VAO);
-    
-    for(unsigned strip = 0; strip < m_numStrips; strip++) {
-        
-        glDrawElements(
-            GL_TRIANGLE_STRIP,
-            m_numTrisPerStrip + 2,
-            GL_UNSIGNED_INT,
-            (void*)(sizeof(unsigned int) * (m_numTrisPerStrip + 2) * strip)
-        );
+void Terrain::render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float pixelsPerUnit) const {
+    m_drawnPatches = 0;
+    m_drawnTriangles = 0;
+    auto level = m_indexLevels.find(m_lodEnabled ? 1 : m_resolution);
+    if (level == m_indexLevels.end() || m_nodeHeights.empty()) {
+        return;
+    }
+
+    Frustum frustum(viewProjection);
+    std::vector<std::pair<float, PatchInstance>> patches;
+    if (m_lodEnabled) {
+        // Nodes are refined inside the next finer level's range, so level L
+        // is only drawn beyond ranges[L - 1] = 2^L * pixelsPerUnit / pixelError.
+        // Its quads are 2^L cells wide there and widen to 2^(L+1) as they
+        // morph, reaching that by ranges[L], so none covers more than
+        // pixelError pixels. Morphing is only seamless if neighbouring nodes
+        // are at most one level apart and the finer one has fully morphed
+        // where they meet, which holds while the unmorphed part of each
+        // level's band is wider than a parent node's diagonal; below that
+        // floor quads are simply smaller than asked for.
+        int levels = static_cast<int>(m_nodeHeights.size());
+        float heightRange = (m_heightMax - m_heightMin) * std::abs(m_yScale);
+        float minimumRange = (std::sqrt(2.0f) * 2.0f * kChunkSize + heightRange) / kMorphStart;
+        float baseRange = std::max(2.0f * pixelsPerUnit / m_lodPixelError, minimumRange);
+        std::vector<float> ranges(levels);
+        for (int l = 0; l < levels; ++l) {
+            ranges[l] = baseRange * static_cast<float>(1 << l);
+        }
+        selectNode(levels - 1, 0, 0, frustum, cameraPosition, ranges, patches);
+    } else {
+        // Every chunk at the chosen resolution, with morphing out of reach
+        for (int i = 0; i < m_chunkRows; i++) {
+            for (int j = 0; j < m_chunkColumns; j++) {
+                glm::vec3 lo, hi;
+                nodeBounds(0, i, j, lo, hi);
+                if (!frustum.intersects(lo, hi)) {
+                    continue;
+                }
+                PatchInstance patch{static_cast<float>(i * kChunkSize), static_cast<float>(j * kChunkSize), 1.0f,
+                                    std::numeric_limits<float>::max() / 2, std::numeric_limits<float>::max()};
+                glm::vec3 offset = (lo + hi) * 0.5f - cameraPosition;
+                patches.push_back({glm::dot(offset, offset), patch});
+            }
+        }
+    }
+    if (patches.empty()) {
+        return;
+    }
+
+    // Front to back so the depth test rejects hidden fragments early
+    std::sort(patches.begin(), patches.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<PatchInstance> instances(patches.size());
+    for (std::size_t i = 0; i < patches.size(); i++) {
+        instances[i] = patches[i].second;
     }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_materials);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(PatchInstance), instances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level->second.buffer);
+
+    // One call for every visible patch, all sharing the same grid
+    glDrawElementsInstanced(GL_TRIANGLE_STRIP, level->second.count, GL_UNSIGNED_SHORT, nullptr,
+                            static_cast<GLsizei>(instances.size()));
+    m_drawnPatches = static_cast<int>(instances.size());
+    m_drawnTriangles = m_drawnPatches * level->second.triangles;
 }
 
+int Terrain::getDrawnPatches() const { return m_drawnPatches; }
+int Terrain::getDrawnTriangles() const { return m_drawnTriangles; }
+
 Terrain::~Terrain() {
+    // The worker uses this object's caches, so it has to stop first
+    if (m_job.valid()) {
+        m_control->cancel();
+        m_job.wait();
+    }
     if (m_VAO) glDeleteVertexArrays(1, &m_VAO);
-    if (m_VBO) glDeleteBuffers(1, &m_VBO);
-    if (m_IBO) glDeleteBuffers(1, &m_IBO);
+    if (m_instanceBuffer) glDeleteBuffers(1, &m_instanceBuffer);
+    clearIndexLevels();
+    if (m_heightTexture) glDeleteTextures(1, &m_heightTexture);
 }
\ No newline at end of file
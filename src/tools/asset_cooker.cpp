@@ -0,0 +1,55 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+#include <render/texture_array.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Cooks material images into one pre-mipmapped texture array that the app
+// uploads without decoding or generating mipmaps at startup.
+//
+//   TerraCook <output.tnta> [--size N] [--bc1] <image>...
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    int size = 512;
+    bool bc1 = false;
+    std::vector<std::string> images;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bc1") == 0) {
+            bc1 = true;
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            images.push_back(argv[i]);
+        }
+    }
+    if (!output || images.empty()) {
+        std::cerr << "usage: TerraCook <output.tnta> [--size N] [--bc1] <image>..." << std::endl;
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        TextureArrayData data = buildTextureArray(images, size);
+        if (bc1) {
+            compressBC1(data);
+        }
+        writeTextureArray(output, data);
+        auto end = std::chrono::steady_clock::now();
+
+        std::size_t bytes = 0;
+        for (const auto& level : data.levels) bytes += level.size();
+        std::cout << output << ": " << data.layers << " layers, " << size << "x" << size << ", "
+                  << data.levels.size() << " mips, " << (bc1 ? "BC1" : "RGBA8") << ", "
+                  << bytes / 1024 << " KiB in "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
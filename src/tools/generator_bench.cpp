@@ -0,0 +1,56 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <terrain/terrain.h>
+#include <parallel/thread_pool.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// Times PerlinNoiseGenerator for 1..N worker threads and checks that every
+// thread count produces exactly the same height map.
+//
+//   TerraBench [size] [maxThreads]
+int main(int argc, char** argv) {
+    int size = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (size <= 0 || maxThreads <= 0) {
+        std::cerr << "usage: TerraBench [size] [maxThreads]" << std::endl;
+        return 1;
+    }
+
+    HeightField reference;
+    double baseline = 0.0;
+
+    std::cout << "PerlinNoiseGenerator " << size << "x" << size << std::endl;
+    std::cout << "threads\tms\tspeedup\tidentical" << std::endl;
+
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        ThreadPool::setGlobalThreadCount(threads);
+
+        HeightField heightMap(size, size);
+        PerlinNoiseGenerator generator(0.015f, 5, 0.5f);
+
+        auto start = std::chrono::steady_clock::now();
+        generator.generateHeightMap(heightMap);
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        bool identical = true;
+        if (threads == 1) {
+            reference = heightMap;
+            baseline = ms;
+        } else {
+            for (int x = 0; x < size && identical; ++x) {
+                identical = std::memcmp(reference.row(x), heightMap.row(x), size * sizeof(float)) == 0;
+            }
+        }
+
+        std::cout << threads << "\t" << ms << "\t" << baseline / ms << "\t" << (identical ? "yes" : "NO") << std::endl;
+        if (!identical) {
+            return 1;
+        }
+    }
+
+    return 0;
+}